@@ -0,0 +1,35 @@
+#include "AllocCounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#ifndef NDEBUG
+
+namespace {
+std::atomic<std::uint64_t> allocations{0};
+thread_local std::uint64_t threadAllocations = 0;
+}
+
+// 默认的 new[] / nothrow 版本都会转调这里，因此只需替换这一组
+void* operator new(std::size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	++threadAllocations;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+bool AllocCounter::enabled() { return true; }
+std::uint64_t AllocCounter::count() { return allocations.load(std::memory_order_relaxed); }
+std::uint64_t AllocCounter::threadCount() { return threadAllocations; }
+
+#else
+
+bool AllocCounter::enabled() { return false; }
+std::uint64_t AllocCounter::count() { return 0; }
+std::uint64_t AllocCounter::threadCount() { return 0; }
+
+#endif
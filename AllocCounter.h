@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// 调试用堆分配计数：未定义 NDEBUG 时替换全局 operator new 并统计调用次数，
+// 用来断言稳定运行时每帧没有堆分配；发布构建（-DNDEBUG）中不替换，计数恒为 0。
+namespace AllocCounter {
+	// 计数是否生效
+	bool enabled();
+	// 进程启动以来的 operator new 调用次数（包括 new[] 与第三方库的分配）
+	std::uint64_t count();
+	// 调用线程自启动以来的 operator new 调用次数（多线程时用于只检查本线程的分配）
+	std::uint64_t threadCount();
+}
@@ -1,83 +1,79 @@
 #include "Ball.h"
+#include "BallStore.h"
 #include <cmath>
 
-// 根据等级决定大小（像素半径）
-static float getRadiusByLevel(int level)
+// 与 PhysicsKernels.cpp 相同：积分是向量内核的标量参考，禁止融合乘加
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// 根据等级决定大小（像素半径），超出查表范围的等级按同一线性规则外推
+float Ball::getRadiusByLevel(int level)
 {
-	// 放大基准半径与每级增量，让球体积更大，便于更容易触达生命线
-	return 18.f + level * 8.f; // level 0 -> 18, 每级增大 8px
+	if (level >= 0 && level < RuleSet::MAX_LEVELS) return Rules::CLASSIC.radius[level];
+	return Rules::CLASSIC.radius[0] + level * (Rules::CLASSIC.radius[1] - Rules::CLASSIC.radius[0]);
 }
 
-Ball::Ball(float x, float y, int lvl, const sf::Color& color, const sf::Texture* texture)
-	: level(lvl)
+template <const RuleSet& R>
+void Ball::integrate(BallStore& b, size_t begin, size_t end, float deltaTime)
 {
-	isDead = false;
-	velocity = sf::Vector2f(0.f, 0.f);
+	constexpr float GRAVITY = R.gravity;
+	constexpr float FLOOR_Y = R.floorY;
+	constexpr float RESTITUTION = R.restitution;
+	constexpr float FRICTION = R.friction;
 
-	radius = getRadiusByLevel(level);
-	circle.setRadius(radius);
-	if (texture) {
-		circle.setTexture(texture);
-		circle.setFillColor(sf::Color::White); // 使用纹理时设为白色以免混色
-	} else {
-		circle.setFillColor(color);
-	}
-	circle.setOrigin(radius, radius);
-	circle.setPosition(x, y);
+	for (size_t i = begin; i < end; ++i) {
+		// 记录上一帧位置
+		b.prevX[i] = b.x[i];
+		b.prevY[i] = b.y[i];
 
-	// 质量与面积相关（近似）：质量与半径的平方成正比
-	mass = std::max(0.1f, radius * radius * 0.001f);
-}
+		// 增加生存时间
+		b.age[i] += deltaTime;
 
-void Ball::update(float deltaTime)
-{
-	// 记录上一帧位置
-	prevPosition = circle.getPosition();
+		float vx = b.vx[i];
+		float vy = b.vy[i];
+		const float r = b.radius[i];
 
-	// 增加生存时间
-	age += deltaTime;
+		// 重力（Y 方向）
+		vy += GRAVITY * deltaTime;
 
-	// 重力（Y 方向）
-	velocity.y += GRAVITY * deltaTime;
+		// 移动：水平与竖直
+		b.x[i] += vx * deltaTime;
+		float py = b.y[i] + vy * deltaTime;
 
-	// 移动：水平与竖直
-	circle.move(velocity.x * deltaTime, velocity.y * deltaTime);
+		// 地面判定与弹性处理
+		bool onGround = false;
+		if (py + r >= FLOOR_Y) {
+			py = FLOOR_Y - r;
 
-	// 地面判定与弹性处理
-	sf::Vector2f pos = circle.getPosition();
-	if (pos.y + radius >= FLOOR_Y) {
-		pos.y = FLOOR_Y - radius;
-		circle.setPosition(pos);
+			if (std::abs(vy) > 0.0f) {
+				vy = -vy * RESTITUTION;
+			}
 
-		if (std::abs(velocity.y) > 0.0f) {
-			velocity.y = -velocity.y * RESTITUTION;
-		}
+			if (std::abs(vy) < 30.f) {
+				vy = 0.f;
+				onGround = true;
+			}
 
-		if (std::abs(velocity.y) < 30.f) {
-			velocity.y = 0.f;
-			isOnGround = true;
-		} else {
-			isOnGround = false;
+			if (onGround) {
+				float sign = (vx >= 0.f) ? 1.f : -1.f;
+				float dec = FRICTION * deltaTime; // 速度减少量
+				if (std::abs(vx) <= dec) vx = 0.f;
+				else vx -= sign * dec;
+			}
 		}
 
-		if (isOnGround) {
-			float sign = (velocity.x >= 0.f) ? 1.f : -1.f;
-			float dec = FRICTION * deltaTime; // 速度减少量
-			if (std::abs(velocity.x) <= dec) velocity.x = 0.f;
-			else velocity.x -= sign * dec;
-		}
-	} else {
-		isOnGround = false;
-	}
-
-	if (std::abs(velocity.x) < 0.01f) velocity.x = 0.f;
-}
+		if (std::abs(vx) < 0.01f) vx = 0.f;
 
-void Ball::render(sf::RenderWindow& window)
-{
-	window.draw(circle);
+		b.y[i] = py;
+		b.vx[i] = vx;
+		b.vy[i] = vy;
+		b.setFlag(i, BallStore::ON_GROUND, onGround);
+	}
 }
 
-sf::Vector2f Ball::getPosition() const { return circle.getPosition(); }
-float Ball::getRadius() const { return radius; }
-int Ball::getLevel() const { return level; }
\ No newline at end of file
+#define SBS_INSTANTIATE_INTEGRATE(R) template void Ball::integrate<Rules::R>(BallStore&, size_t, size_t, float);
+SBS_RULE_SETS(SBS_INSTANTIATE_INTEGRATE)
+#undef SBS_INSTANTIATE_INTEGRATE
@@ -0,0 +1,118 @@
+#include "BallStore.h"
+#include "Rules.h"
+
+size_t BallStore::add(float px, float py, int lvl, const RuleSet& rules)
+{
+	const float r = rules.radius[lvl];
+	x.push_back(px);
+	y.push_back(py);
+	vx.push_back(0.f);
+	vy.push_back(0.f);
+	radius.push_back(r);
+	mass.push_back(rules.mass[lvl]);
+	level.push_back(static_cast<std::uint8_t>(lvl));
+	flags.push_back(0);
+	prevX.push_back(px);
+	prevY.push_back(py);
+	startX.push_back(px);
+	startY.push_back(py);
+	age.push_back(0.f);
+	timeAboveLine.push_back(0.f);
+	calmTime.push_back(0.f);
+	island.push_back(-1);
+	slot.push_back(acquireSlot(x.size() - 1));
+	return x.size() - 1;
+}
+
+std::uint32_t BallStore::acquireSlot(size_t index)
+{
+	std::uint32_t s;
+	if (!freeSlots.empty()) {
+		s = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		s = static_cast<std::uint32_t>(slotIndex.size());
+		slotIndex.push_back(NO_SLOT);
+		slotGeneration.push_back(0);
+	}
+	slotIndex[s] = static_cast<std::uint32_t>(index);
+	return s;
+}
+
+void BallStore::releaseSlot(std::uint32_t s)
+{
+	slotIndex[s] = NO_SLOT;
+	++slotGeneration[s];
+	freeSlots.push_back(s);
+}
+
+void BallStore::rebindHandles()
+{
+	for (std::uint32_t s = 0; s < slotIndex.size(); ++s)
+		if (slotIndex[s] != NO_SLOT) releaseSlot(s);
+	slot.resize(size());
+	for (size_t i = 0; i < size(); ++i) slot[i] = acquireSlot(i);
+}
+
+void BallStore::removeDead()
+{
+	const size_t n = size();
+	size_t w = 0;
+	for (size_t i = 0; i < n; ++i) {
+		if (flags[i] & DEAD) {
+			releaseSlot(slot[i]);
+			continue;
+		}
+		if (w != i) {
+			x[w] = x[i]; y[w] = y[i];
+			vx[w] = vx[i]; vy[w] = vy[i];
+			radius[w] = radius[i]; mass[w] = mass[i];
+			level[w] = level[i]; flags[w] = flags[i];
+			prevX[w] = prevX[i]; prevY[w] = prevY[i];
+			startX[w] = startX[i]; startY[w] = startY[i];
+			age[w] = age[i]; timeAboveLine[w] = timeAboveLine[i];
+			calmTime[w] = calmTime[i]; island[w] = island[i];
+			slot[w] = slot[i];
+			slotIndex[slot[w]] = static_cast<std::uint32_t>(w);
+		}
+		++w;
+	}
+	if (w == n) return;
+	x.resize(w); y.resize(w);
+	vx.resize(w); vy.resize(w);
+	radius.resize(w); mass.resize(w);
+	level.resize(w); flags.resize(w);
+	prevX.resize(w); prevY.resize(w);
+	startX.resize(w); startY.resize(w);
+	age.resize(w); timeAboveLine.resize(w);
+	calmTime.resize(w); island.resize(w);
+	slot.resize(w);
+}
+
+void BallStore::reserve(size_t n)
+{
+	x.reserve(n); y.reserve(n);
+	vx.reserve(n); vy.reserve(n);
+	radius.reserve(n); mass.reserve(n);
+	level.reserve(n); flags.reserve(n);
+	prevX.reserve(n); prevY.reserve(n);
+	startX.reserve(n); startY.reserve(n);
+	age.reserve(n); timeAboveLine.reserve(n);
+	calmTime.reserve(n); island.reserve(n);
+	slot.reserve(n);
+	slotIndex.reserve(n); slotGeneration.reserve(n); freeSlots.reserve(n);
+}
+
+void BallStore::clear()
+{
+	x.clear(); y.clear();
+	vx.clear(); vy.clear();
+	radius.clear(); mass.clear();
+	level.clear(); flags.clear();
+	prevX.clear(); prevY.clear();
+	startX.clear(); startY.clear();
+	age.clear(); timeAboveLine.clear();
+	calmTime.clear(); island.clear();
+	for (std::uint32_t s : slot) releaseSlot(s);
+	slot.clear();
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+struct RuleSet;
+
+// 结构数组（SoA）形式的球状态：每个字段一条连续数组。
+// 积分与碰撞循环只读写热数据（位置/速度/半径/质量/等级/标志），
+// 冷数据（上一帧位置、插值起点、存活时间、生命线计时）单独存放，不占用热循环的缓存行。
+//
+// 下标只在一个固定步内有效（步末压缩会移动球）。需要跨步引用某个球的外部系统（AI、渲染、遥测）
+// 使用 Handle：句柄指向槽位表中的一个槽，槽记录球当前的下标与代数。球被移除时槽的代数加一并放回空闲表，
+// 旧句柄因代数不符而失效，因此句柄永远不会错指到复用同一槽位的新球。
+struct BallStore {
+	static constexpr std::uint32_t NO_SLOT = 0xffffffffu;
+	static constexpr size_t NPOS = static_cast<size_t>(-1);
+
+	// 球的稳定引用（默认构造为无效句柄）
+	struct Handle {
+		std::uint32_t slot = NO_SLOT;
+		std::uint32_t generation = 0;
+		bool valid() const { return slot != NO_SLOT; }
+		bool operator==(const Handle& o) const { return slot == o.slot && generation == o.generation; }
+		bool operator!=(const Handle& o) const { return !(*this == o); }
+	};
+
+	enum Flag : std::uint8_t {
+		DEAD = 1,              // 已被合并，等待本步末尾压缩移除
+		ON_GROUND = 2,         // 在地面上且竖直速度已衰减为 0
+		SPAWNED_ABOVE_LINE = 4, // 生成时已位于生命线上方
+		SLEEPING = 8,           // 所在岛已静止：跳过积分与球对扫描，直到被唤醒
+		SWEPT = 16              // 本子步位移过大、正在做连续碰撞扫掠（只在扫掠期间存在）
+	};
+
+	// 热数据
+	std::vector<float> x, y;
+	std::vector<float> vx, vy;
+	std::vector<float> radius;
+	std::vector<float> mass;
+	std::vector<std::uint8_t> level;
+	std::vector<std::uint8_t> flags;
+
+	// 冷数据
+	std::vector<float> prevX, prevY;   // 上一子步开始时的位置（生命线穿越判定）
+	std::vector<float> startX, startY; // 当前固定步开始时的位置（渲染插值）
+	std::vector<float> age;            // 存活时间（秒）
+	std::vector<float> timeAboveLine;  // 连续位于生命线上方的时间（秒）
+	std::vector<float> calmTime;       // 速度连续低于休眠阈值的时间（秒）
+	std::vector<int> island;           // 休眠岛编号（仅 SLEEPING 的球有效）
+	std::vector<std::uint32_t> slot;   // 该球占用的句柄槽位
+
+	size_t size() const { return x.size(); }
+	bool empty() const { return x.empty(); }
+
+	bool isDead(size_t i) const { return (flags[i] & DEAD) != 0; }
+	bool isOnGround(size_t i) const { return (flags[i] & ON_GROUND) != 0; }
+	bool isSleeping(size_t i) const { return (flags[i] & SLEEPING) != 0; }
+	void setFlag(size_t i, Flag f, bool on) { flags[i] = static_cast<std::uint8_t>(on ? (flags[i] | f) : (flags[i] & ~f)); }
+
+	// 追加一个静止的球（半径与质量按规则集的查表由等级决定），返回其下标
+	size_t add(float px, float py, int lvl, const RuleSet& rules);
+	// 稳定压缩：移除所有 DEAD 球并保持其余球的相对顺序（同时释放其槽位、更新移动球的槽位下标）
+	void removeDead();
+	void reserve(size_t n);
+	void clear();
+
+	// 下标 i 处的球的句柄
+	Handle handle(size_t i) const { return {slot[i], slotGeneration[slot[i]]}; }
+	// 句柄对应的当前下标；球已被移除（或已死亡、等待本步末尾移除）时返回 NPOS
+	size_t find(Handle h) const
+	{
+		if (h.slot >= slotIndex.size() || slotGeneration[h.slot] != h.generation) return NPOS;
+		const std::uint32_t i = slotIndex[h.slot];
+		return (i == NO_SLOT || isDead(i)) ? NPOS : i;
+	}
+	// 数组被整体替换后（例如从快照恢复）：作废所有旧句柄，并为现有的球重新分配槽位
+	void rebindHandles();
+
+private:
+	std::uint32_t acquireSlot(size_t index);
+	void releaseSlot(std::uint32_t s);
+
+	// 槽位表：槽 -> 当前下标（空闲时为 NO_SLOT）与代数；空闲槽按后进先出复用，分配与释放都是 O(1)
+	std::vector<std::uint32_t> slotIndex;
+	std::vector<std::uint32_t> slotGeneration;
+	std::vector<std::uint32_t> freeSlots;
+};
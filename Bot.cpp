@@ -0,0 +1,104 @@
+#include "Bot.h"
+#include "Rng.h"
+#include <chrono>
+#include <thread>
+
+namespace {
+
+// 输掉一局的惩罚：远大于任何得分增量与余量之和
+const double LOSS_PENALTY = 1e7;
+
+// 由决策序号与推演编号派生互不相关的种子（splitmix64）
+std::uint64_t mixSeed(std::uint64_t a, std::uint64_t b)
+{
+	std::uint64_t z = a + 0x9e3779b97f4a7c15ull * (b + 1);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+	return z ^ (z >> 31);
+}
+
+} // namespace
+
+Bot::Bot()
+	: Bot(Config())
+{
+}
+
+Bot::Bot(const Config& cfg)
+	: config(cfg)
+{
+	if (config.candidates < 1) config.candidates = 1;
+	if (config.rollouts < 1) config.rollouts = 1;
+	unsigned n = config.threads ? config.threads : std::thread::hardware_concurrency();
+	if (n > 1) pool.reset(new ThreadPool(n));
+	sims.resize(pool ? pool->size() : 1);
+	threadSteps.resize(sims.size());
+	value.resize(static_cast<size_t>(config.candidates));
+}
+
+float Bot::candidateX(const World& world, int c) const
+{
+	// 与 World::spawnBall 的横向限制一致：两侧各留 28 像素
+	const float lo = 28.f;
+	const float hi = world.getWidth() - 28.f;
+	if (config.candidates == 1) return (lo + hi) * 0.5f;
+	return lo + (hi - lo) * static_cast<float>(c) / static_cast<float>(config.candidates - 1);
+}
+
+// 一次推演：在 x 投放当前预览等级，之后随机投放 lookaheadDrops 次，每次投放后推进 settleSteps 步
+double Bot::rollout(World& sim, const World& world, float x, std::uint64_t rolloutSeed, std::uint64_t& steps) const
+{
+	sim.copyStateFrom(world);
+	Rng rng(rolloutSeed);
+	const int startScore = world.getScore();
+	const int width = static_cast<int>(world.getWidth());
+	for (int d = 0; d <= config.lookaheadDrops && !sim.isGameOver() && !sim.isGameWin(); ++d) {
+		sim.dropNext(d == 0 ? x : static_cast<float>(rng.below(width)), DROP_Y);
+		for (int s = 0; s < config.settleSteps && !sim.isGameOver(); ++s) {
+			sim.step(STEP);
+			++steps;
+		}
+	}
+	double v = static_cast<double>(sim.getScore() - startScore) + config.headroomWeight * sim.getDangerHeight();
+	if (sim.isGameOver()) v -= LOSS_PENALTY;
+	return v;
+}
+
+float Bot::chooseDrop(const World& world)
+{
+	auto t0 = std::chrono::steady_clock::now();
+	const size_t tasks = static_cast<size_t>(config.candidates) * static_cast<size_t>(config.rollouts);
+	const std::uint64_t decisionSeed = mixSeed(config.seed, stats.decisions);
+	std::fill(value.begin(), value.end(), 0.0);
+	std::fill(threadSteps.begin(), threadSteps.end(), 0);
+
+	// 线程 t 处理任务 t, t + T, ...；每个任务写自己的候选槽位之外不共享状态，
+	// 同一候选的多次推演由同一线程按顺序累加，因此结果与线程数无关
+	const size_t parts = sims.size();
+	auto work = [&](size_t lo, size_t hi) {
+		for (size_t t = lo; t < hi; ++t) {
+			if (!sims[t] || sims[t]->getMaxBalls() != world.getMaxBalls() || &sims[t]->getRules() != &world.getRules())
+				sims[t].reset(new World(world.getRules(), world.getWidth(), world.getHeight(), world.getMaxBalls()));
+			World& sim = *sims[t];
+			for (size_t c = t; c < value.size(); c += parts) {
+				float x = candidateX(world, static_cast<int>(c));
+				double sum = 0.0;
+				for (int r = 0; r < config.rollouts; ++r)
+					sum += rollout(sim, world, x, mixSeed(decisionSeed, c * config.rollouts + r), threadSteps[t]);
+				value[c] = sum;
+			}
+		}
+	};
+	if (pool) pool->parallelFor(parts, 1, 1, work);
+	else work(0, parts);
+
+	size_t best = 0;
+	for (size_t c = 1; c < value.size(); ++c)
+		if (value[c] > value[best]) best = c;
+
+	++stats.decisions;
+	stats.rollouts += tasks;
+	for (std::uint64_t s : threadSteps) stats.steps += s;
+	stats.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	return candidateX(world, static_cast<int>(best));
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "World.h"
+#include "ThreadPool.h"
+
+// 无窗口的蒙特卡洛投放 AI：对当前局面的每个候选投放横坐标，
+// 复制 World 并在线程池上做若干次随机推演（候选投放 + 之后若干次随机投放），
+// 以平均的得分增量与堆顶余量（距生命线的像素）选出最优位置。
+// 推演的随机数只由种子、决策序号与推演编号决定，结果与线程数无关。
+class Bot {
+public:
+	struct Config {
+		int candidates = 16;          // 在容器内均匀分布的候选投放横坐标数
+		int rollouts = 4;             // 每个候选的随机推演次数
+		int lookaheadDrops = 2;       // 候选投放之后再随机投放的次数
+		int settleSteps = 120;        // 每次投放后推进的固定步数
+		float headroomWeight = 10.f;  // 每像素堆顶余量折合的分数
+		unsigned threads = 0;         // 推演线程数（0 表示取硬件线程数）
+		std::uint64_t seed = 1;
+	};
+
+	// 累计统计：推演局数、模拟的固定步数与 chooseDrop 的墙钟耗时
+	struct Stats {
+		std::uint64_t decisions = 0;
+		std::uint64_t rollouts = 0;
+		std::uint64_t steps = 0;
+		double seconds = 0.0;
+	};
+
+	Bot();
+	explicit Bot(const Config& cfg);
+
+	// 为 world 当前的 nextSpawnLevel 选择投放横坐标（world 本身不被修改）
+	float chooseDrop(const World& world);
+
+	const Config& getConfig() const { return config; }
+	const Stats& getStats() const { return stats; }
+	unsigned getThreads() const { return pool ? pool->size() : 1; }
+
+	// 投放点的纵坐标（容器顶部附近）与推演使用的固定步长
+	static constexpr float DROP_Y = 40.f;
+	static constexpr float STEP = 1.f / 60.f;
+
+private:
+	double rollout(World& sim, const World& world, float x, std::uint64_t rolloutSeed, std::uint64_t& steps) const;
+	float candidateX(const World& world, int c) const;
+
+	Config config;
+	std::unique_ptr<ThreadPool> pool;
+	std::vector<std::unique_ptr<World>> sims; // 每个线程一份推演用的 World，按需创建
+	std::vector<double> value;                // 每个候选的推演总价值
+	std::vector<std::uint64_t> threadSteps;   // 每个线程本次决策模拟的步数
+	Stats stats;
+};
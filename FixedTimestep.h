@@ -0,0 +1,34 @@
+#pragma once
+
+// 累加器式固定步长：把不定长的帧间隔换算成若干个等长的模拟步，
+// 使模拟结果与帧率无关；单帧补步数有上限，长时间卡顿时丢弃多余时间而不是用巨大 dt 积分。
+class FixedTimestep {
+public:
+	explicit FixedTimestep(float stepSeconds = 1.f / 60.f, int maxCatchUpSteps = 5)
+		: step(stepSeconds), maxSteps(maxCatchUpSteps) {}
+
+	// 累加本帧时间，返回本帧应执行的固定步数
+	int advance(float frameSeconds)
+	{
+		if (frameSeconds > 0.f) accumulator += frameSeconds;
+		int n = 0;
+		while (accumulator >= step && n < maxSteps) {
+			accumulator -= step;
+			++n;
+		}
+		// 达到补步上限：剩余时间直接丢弃（模拟相对真实时间变慢，但每帧开销有上界）
+		if (n == maxSteps && accumulator >= step) accumulator = 0.f;
+		return n;
+	}
+
+	// 渲染插值系数 [0,1)：距离下一个模拟步还差多少
+	float alpha() const { return accumulator / step; }
+
+	float getStep() const { return step; }
+	void reset() { accumulator = 0.f; }
+
+private:
+	float step;
+	int maxSteps;
+	float accumulator = 0.f;
+};
@@ -1,204 +1,242 @@
 #include "Game.h"
+#include "AllocCounter.h"
 #include <iostream>
 #include <cmath>
 #include <string>
 #include <algorithm>
-#include <sstream>
-#include <cstdlib>
-#include <ctime>
+#include <cstdio>
+#include <cassert>
 #include <streambuf>
-#include <stack>
+#include <fstream>
+#include <iterator>
+#include <chrono>
 
 // 构造函数
-Game::Game()
-    : window(sf::VideoMode(480, 800), "Synthetic SHU")
+Game::Game(const RuleSet& rules, std::uint64_t seed, const std::string& recordPath_)
+    : window(sf::VideoMode(static_cast<unsigned>(rules.width), static_cast<unsigned>(rules.floorY)), "Synthetic SHU"),
+      world(rules),
+      rules(rules),
+      // 步长经 sf::Time 的微秒取整（与此前逐帧传入 sf::Time 的步长一致，旧记录仍可对照）
+      sim(world, sf::seconds(FIXED_STEP).asSeconds(), MAX_CATCH_UP_STEPS),
+      recordPath(recordPath_)
 {
+    // 帧率限制只约束渲染线程，物理线程按自己的固定步长推进
     window.setFramerateLimit(60);
+    world.setSubsteps(SUBSTEPS);
+    world.setSeed(seed);
+    // 记录物理线程实际传给 World 的步长，回放才能逐位一致
+    if (!recordPath.empty())
+        sessionLog.begin(world, sim.getStep());
+    sim.setHandler([this](World& w, const SimulationThread::Input& in) { applyInput(w, in); });
+    prevFrame.reserve(world.getMaxBalls());
+    currFrame.reserve(world.getMaxBalls());
+    prevIndex.reserve(world.getMaxBalls());
+    currFrame.capture(world);
     loadResources();
 }
 
 // 加载资源
 void Game::loadResources()
 {
-    // 颜色调色板（第 1-3 级为明确可区分的颜色）
-    sf::Color palette[12] = {
-        sf::Color(180,180,180), // 0
-        sf::Color(220, 80, 80),  // 1 - red
-        sf::Color(80, 180, 90),  // 2 - green
-        sf::Color(70, 130, 230), // 3 - blue
-        sf::Color(230, 190, 60), // 4
-        sf::Color(190, 90, 180), // 5
-        sf::Color(90, 190, 200), // 6
-        sf::Color(200, 120, 60), // 7
-        sf::Color(150, 150, 220),// 8
-        sf::Color(220, 120, 120),// 9
-        sf::Color(120, 220, 180),// 10
-        sf::Color(200,200,200)   // 11
-    };
-
-    for (int i = 0; i < 12; ++i) {
-        colors[i] = palette[i];
-    }
-    // 尝试从 assets 加载纹理 (1.png ... 11.png)
-    for (int i = 1; i < 12; ++i) {
-        std::string path = "assets/" + std::to_string(i) + ".png";
-        // 如果加载成功，textures[i] 将包含图像；如果失败，保持为空
-        if (textures[i].loadFromFile(path)) {
-            textures[i].setSmooth(true); // 开启平滑更美观
-        }
+    // 各等级的纯色（规则集在编译期生成的颜色表，第 1-3 级为明确可区分的颜色）
+    for (int i = 0; i < RuleSet::MAX_LEVELS; ++i) {
+        const std::uint32_t c = rules.color[i];
+        colors[i] = sf::Color((c >> 16) & 0xFF, (c >> 8) & 0xFF, c & 0xFF);
     }
-
-    // 尝试加载系统字体以显示分数；在 macOS 上常见路径为 /Library/Fonts/Arial.ttf
-    // 为避免在字体加载失败时 SFML 向 stderr 打印错误信息，我们在尝试加载时暂时屏蔽 sf::err()
-    struct NullBuf : public std::streambuf { int overflow(int c) override { return c; } } nullBuf;
-    std::streambuf* oldBuf = sf::err().rdbuf(&nullBuf);
-    bool fontLoaded = false;
-    const char* candidates[] = {"./resources/arial.ttf", "/Library/Fonts/Arial.ttf", "/System/Library/Fonts/Supplemental/Arial.ttf"};
-    for (auto path : candidates) {
-        if (font.loadFromFile(path)) {
-            fontLoaded = true;
-            break;
-        }
-    }
-    // 恢复 sf::err() 的缓冲区
-    sf::err().rdbuf(oldBuf);
-
-    if (fontLoaded) {
-        scoreText.setFont(font);
-        scoreText.setCharacterSize(20);
-        scoreText.setFillColor(sf::Color::Black);
-        scoreText.setPosition(8.f, 8.f);
-        scoreText.setString("Score: 0");
-    }
-
-    // 随机种子（用于 spawn 的随机初速度）
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
+    // 从 assets 加载纹理 (1.png ... 11.png) 并拼成图集；后台解码完成前（以及缺失的等级）用纯色圆盘
+    atlas.beginLoad("assets");
+    ballVertices.setPrimitiveType(sf::Triangles);
+    // 按球数上限一次性分配顶点缓冲，之后 resize 只改变长度
+    ballVertices.resize(world.getMaxBalls() * 6);
+    ballVertices.resize(0);
+    rebuildLifeline();
+
+    // 字体文件在后台线程读入内存，就绪后由 pollAssets 应用；在此之前不显示文字
+    fontFuture = std::async(std::launch::async, &Game::readFontFile);
+
+    // 下一个球的小预览图标（固定大小，颜色随 nextSpawnLevel 变化）
+    const float PREVIEW_R = 12.f;
+    previewShape.setRadius(PREVIEW_R);
+    previewShape.setOrigin(PREVIEW_R, PREVIEW_R);
+    // 将预览放在 scoreText 下方（与原来等级文本位置相近）
+    previewShape.setPosition(8.f + PREVIEW_R, 34.f + PREVIEW_R);
+    previewShape.setOutlineColor(sf::Color::Black);
+    previewShape.setOutlineThickness(2.f);
+
+    // 胜利/失败界面的半透明遮罩
+    overlay.setFillColor(sf::Color(0,0,0,120));
+    overlay.setSize(sf::Vector2f((float)window.getSize().x, (float)window.getSize().y));
 
     // 初始化 Again 按钮（位置将在 run/render 时基于窗口大小调整）
     againButton.setSize(sf::Vector2f(140.f, 44.f));
     againButton.setFillColor(sf::Color(200, 50, 50));
     againButton.setOutlineColor(sf::Color::Black);
     againButton.setOutlineThickness(2.f);
-    if (fontLoaded) {
-        againText.setFont(font);
-        againText.setCharacterSize(20);
-        againText.setFillColor(sf::Color::White);
-        againText.setString("Again");
-    }
 
-    // 选择初始的下一个生成等级（用于 UI 预览）
-    pickNextSpawnLevel();
+    profilerPanel.setSize(sf::Vector2f(212.f, 14.f * (Profiler::PHASE_COUNT + 1) + 12.f));
+    profilerPanel.setPosition(256.f, 4.f);
+    profilerPanel.setFillColor(sf::Color(0, 0, 0, 160));
 }
 
-// 随机选择下一次要生成的球的等级（遵循已有的 1..3 随机并考虑第3级解锁）
-void Game::pickNextSpawnLevel()
+// 后台线程：依次尝试常见字体路径（macOS 上常见路径为 /Library/Fonts/Arial.ttf），返回第一个可读文件的内容
+std::vector<char> Game::readFontFile()
 {
-    // 默认行为：随机 1..3，若 3 未解锁则退为 1/2
-    int pick = (std::rand() % 3) + 1; // 1..3
-    if (pick == 3 && score < LEVEL3_UNLOCK_SCORE) {
-        pick = (std::rand() % 2) + 1; // 1 or 2
+    const char* candidates[] = {"./resources/arial.ttf", "/Library/Fonts/Arial.ttf", "/System/Library/Fonts/Supplemental/Arial.ttf"};
+    for (auto path : candidates) {
+        std::ifstream in(path, std::ios::binary);
+        if (!in) continue;
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        if (!data.empty()) return data;
     }
-    nextSpawnLevel = pick;
+    return std::vector<char>();
 }
 
-// 生成新球
-void Game::spawnBall(float x, float y, int level)
+// 在主线程上从内存加载字体并设置所有文字；sf::Font 直接引用 fontData，之后不能再修改它
+void Game::applyFont()
 {
-    if (level < 1) level = 1;
-    if (level > MAX_LEVEL) level = MAX_LEVEL;
-    if (balls.size() >= MAX_BALLS) return; // 限制球的总数
-
-    // 保证在容器内部横坐标
-    float winW = static_cast<float>(window.getSize().x);
-    float minX = leftMargin + 8.f;
-    float maxX = winW - rightMargin - 8.f;
-    if (x < minX) x = minX;
-    if (x > maxX) x = maxX;
-
-    // 先创建一个 probe 以获取半径
-    const sf::Texture* pTex = (textures[level].getSize().x > 0) ? &textures[level] : nullptr;
-    Ball probe(x, y, level, colors[level], pTex);
-    float r = probe.getRadius();
-
-    // 尝试不同横向偏移（左右交替）寻找不重叠位置
-    float chosenX = x;
-    float chosenY = y;
-    bool placed = false;
-    const int maxOffsetSteps = 24;
-    for (int step = 0; step < maxOffsetSteps && !placed; ++step) {
-        int k = step/2;
-        int side = (step % 2 == 0) ? 1 : -1;
-        float offset = (k + 0.0f) * (r * 0.85f + 6.f) * side;
-        float nx = x + offset;
-        if (nx < minX + r) nx = minX + r;
-        if (nx > maxX - r) nx = maxX - r;
-
-        bool ok = true;
-        for (auto &b : balls) {
-            float dx = nx - b.getPosition().x;
-            float dy = y - b.getPosition().y;
-            float dist2 = dx*dx + dy*dy;
-            float minDist = (r + b.getRadius()) * 0.82f; // 允许略紧密
-            if (dist2 < minDist * minDist) { ok = false; break; }
-        }
-        if (ok) { chosenX = nx; placed = true; break; }
-    }
+    if (fontData.empty()) return;
+    // 为避免在字体加载失败时 SFML 向 stderr 打印错误信息，我们在尝试加载时暂时屏蔽 sf::err()
+    struct NullBuf : public std::streambuf { int overflow(int c) override { return c; } } nullBuf;
+    std::streambuf* oldBuf = sf::err().rdbuf(&nullBuf);
+    bool fontLoaded = font.loadFromMemory(fontData.data(), fontData.size());
+    // 恢复 sf::err() 的缓冲区
+    sf::err().rdbuf(oldBuf);
+    if (!fontLoaded) return;
+
+    scoreText.setFont(font);
+    scoreText.setCharacterSize(20);
+    scoreText.setFillColor(sf::Color::Black);
+    scoreText.setPosition(8.f, 8.f);
+    scoreText.setString("Score: 0");
+
+    winText.setFont(font);
+    winText.setCharacterSize(28);
+    winText.setFillColor(sf::Color::White);
+    winText.setString("恭喜你合成出上海大学");
+
+    previewText.setFont(font);
+    previewText.setCharacterSize(12);
+    previewText.setFillColor(sf::Color::Black);
+
+    loseText.setFont(font);
+    loseText.setCharacterSize(36);
+    loseText.setFillColor(sf::Color::White);
+    loseText.setString("You lose");
+
+    againText.setFont(font);
+    againText.setCharacterSize(20);
+    againText.setFillColor(sf::Color::White);
+    againText.setString("Again");
+
+    profilerText.setFont(font);
+    profilerText.setCharacterSize(12);
+    profilerText.setFillColor(sf::Color::White);
+    profilerText.setPosition(262.f, 10.f);
+
+    // 让 refreshHud 按新字体重建分数与预览文字
+    shownScore = -1;
+    shownPreviewLevel = 0;
+}
 
-    // 如果横向没有合适位置，尝试向上抬高更多步以便堆叠
-    if (!placed) {
-        const int upAttempts = 30;
-        for (int u = 1; u <= upAttempts && !placed; ++u) {
-            float ny = y - u * (r * 0.9f + 4.f);
-            if (ny < r + 8.f) break;
-            for (int step = 0; step < maxOffsetSteps && !placed; ++step) {
-                int k = step/2;
-                int side = (step % 2 == 0) ? 1 : -1;
-                float offset = (k + 0.0f) * (r * 0.85f + 6.f) * side;
-                float nx = x + offset;
-                if (nx < minX + r) nx = minX + r;
-                if (nx > maxX - r) nx = maxX - r;
-                bool ok = true;
-                for (auto &b : balls) {
-                    float dx = nx - b.getPosition().x;
-                    float dy = ny - b.getPosition().y;
-                    float dist2 = dx*dx + dy*dy;
-                    float minDist = (r + b.getRadius()) * 0.82f;
-                    if (dist2 < minDist * minDist) { ok = false; break; }
-                }
-                if (ok) { chosenX = nx; chosenY = ny; placed = true; break; }
-            }
-        }
+// 每帧推进异步资源加载：上传已解码的贴图格子、应用已读入的字体；全部就绪时输出启动耗时
+void Game::pollAssets()
+{
+    if (texturesReadyMs < 0 && atlas.update())
+        texturesReadyMs = startupClock.getElapsedTime().asMilliseconds();
+    if (fontFuture.valid() && fontFuture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+        fontData = fontFuture.get();
+        applyFont();
+        fontReadyMs = startupClock.getElapsedTime().asMilliseconds();
     }
-
-    if (!placed) {
-        // 如果确实放不下，则尝试在窗口顶部少许位置生成（让它自然落下）
-        float topY = r + 12.f;
-        chosenX = std::min(std::max(x, minX + r), maxX - r);
-        chosenY = topY;
+    if (startupReport && texturesReadyMs >= 0 && fontReadyMs >= 0 && firstFrameMs >= 0) {
+        std::cout << "startup (" << (atlas.loadedFromCache() ? "warm, atlas cache" : "cold, decoded PNGs") << "): "
+                  << "first frame " << firstFrameMs << " ms, textures " << texturesReadyMs
+                  << " ms, font " << fontReadyMs << " ms" << std::endl;
+        window.close();
     }
+}
 
-    const sf::Texture* bTex = (textures[level].getSize().x > 0) ? &textures[level] : nullptr;
-    balls.emplace_back(chosenX, chosenY, level, colors[level], bTex);
-    // 给一点初速度避免完全垂直停滞
-    float vy = -90.f + (std::rand() % 80 - 40);
-    float vx = (std::rand() % 80 - 40) * 0.4f;
-    balls.back().setVelocity(sf::Vector2f(vx, vy));
-    // 初始化生命线相关字段，避免 spawn 时被立即判死
-    balls.back().prevPosition = balls.back().getPosition();
-    balls.back().timeAboveLine = 0.f;
-    balls.back().wasSpawnedAboveLine = (chosenY - balls.back().getRadius() <= lifelineY);
+Game::~Game()
+{
+    sim.stop();
 }
 
-// 游戏主循环
+// 游戏主循环（渲染线程）：物理在 SimulationThread 上独立推进，这里只投递输入并绘制最新一帧
 void Game::run()
 {
-    sf::Clock clock;
+    // 调试构建：稳定帧（无输入、球数与分数都不变）内取帧与顶点构建不得有堆分配（只统计本线程）
+    size_t lastBallCount = 0;
+    int lastScore = -1;
+    sim.start();
     while (window.isOpen()) {
-        sf::Time deltaTime = clock.restart();
+        // 剖析器只在打开统计面板时挂接；关闭时不读时钟。物理线程的各阶段区间写入同一个剖析器
+        Profiler* prof = showProfiler ? &profiler : nullptr;
+        if (prof) prof->nextFrame();
+        std::uint64_t frameStart = prof ? Profiler::now() : 0;
+        inputThisFrame = false;
         processEvents();
-        update(deltaTime);
+        pollAssets();
+
+        std::uint64_t renderStart = prof ? Profiler::now() : 0;
+        std::uint64_t allocs = AllocCounter::threadCount();
+        acquireFrame();
+        buildBallVertices(interpolationAlpha());
+        allocs = AllocCounter::threadCount() - allocs;
+
+        size_t ballCount = currFrame.size();
+        bool steady = !inputThisFrame && ballCount == lastBallCount && currFrame.score == lastScore;
+        assert((!steady || allocs == 0) && "heap allocation in a steady-state frame");
+        (void)steady;
+        lastBallCount = ballCount;
+        lastScore = currFrame.score;
+
+        if (currFrame.lifelineY != shownLifelineY) rebuildLifeline();
+        refreshHud();
         render();
+        // 帧与渲染耗时不含 display 中的帧率限制等待
+        if (prof) {
+            std::uint64_t now = Profiler::now();
+            prof->record(Profiler::Render, renderStart, now);
+            prof->record(Profiler::Frame, frameStart, now);
+        }
+        window.display();
+        if (firstFrameMs < 0) firstFrameMs = startupClock.getElapsedTime().asMilliseconds();
+    }
+    sim.stop();
+
+    if (!recordPath.empty()) {
+        sessionLog.finish(world);
+        if (sessionLog.save(recordPath))
+            std::cout << "session recorded to " << recordPath << " (seed " << world.getSeed() << ")" << std::endl;
+        else
+            std::cerr << "failed to write session log " << recordPath << std::endl;
+    }
+}
+
+// 取物理线程发布的最新一帧：当前帧先复制为上一帧，并按句柄槽位建立上一帧的下标表
+bool Game::acquireFrame()
+{
+    TripleBuffer<SimFrame>& frames = sim.frames();
+    if (!frames.acquire()) return false;
+    prevFrame = currFrame;
+    currFrame = frames.readBuffer();
+    for (size_t i = 0; i < prevFrame.size(); ++i) {
+        std::uint32_t slot = prevFrame.handle[i].slot;
+        if (slot >= prevIndex.size()) prevIndex.resize(slot + 1, -1);
+        prevIndex[slot] = static_cast<std::int32_t>(i);
     }
+    return true;
+}
+
+// 渲染时刻比当前时间晚一个固定步，落在最近两帧的发布时刻之间：按时间比例插值（超出时取端点）
+float Game::interpolationAlpha() const
+{
+    if (prevFrame.publishNs == 0 || currFrame.publishNs <= prevFrame.publishNs) return 1.f;
+    const double stepNs = sim.getStep() * 1e9;
+    const double renderNs = static_cast<double>(Profiler::now()) - stepNs;
+    const double t = (renderNs - static_cast<double>(prevFrame.publishNs))
+        / static_cast<double>(currFrame.publishNs - prevFrame.publishNs);
+    return static_cast<float>(std::min(1.0, std::max(0.0, t)));
 }
 
 // 处理事件（鼠标点击）
@@ -209,22 +247,23 @@ void Game::processEvents()
         if (event.type == sf::Event::Closed)
             window.close();
 
+        // 窗口尺寸变化时重建生命线几何
+        if (event.type == sf::Event::Resized) {
+            rebuildLifeline();
+            overlay.setSize(sf::Vector2f((float)window.getSize().x, (float)window.getSize().y));
+        }
+
         if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+            inputThisFrame = true;
             sf::Vector2i pos = sf::Mouse::getPosition(window);
-            if (!gameOver) {
-                // 使用已经预选的 nextSpawnLevel 来生成球，然后再选一个新的 nextSpawnLevel
-                int pick = nextSpawnLevel;
-                // 作为保险，如果 pick 超过 MAX_LEVEL 或小于 1，则修正
-                if (pick < 1) pick = 1;
-                if (pick > MAX_LEVEL) pick = MAX_LEVEL;
-                spawnBall(static_cast<float>(pos.x), static_cast<float>(pos.y), pick);
-                // 生成后立刻选择下一个预览
-                pickNextSpawnLevel();
+            if (!currFrame.gameOver) {
+                // 使用已经预选的等级生成球，World 随后选择新的预览
+                sim.post({DropInput, static_cast<float>(pos.x), static_cast<float>(pos.y)});
             } else {
                 // 如果处于 gameOver，则检查 Again 按钮点击
                 sf::Vector2f mp(static_cast<float>(pos.x), static_cast<float>(pos.y));
                 if (againButton.getGlobalBounds().contains(mp)) {
-                    resetGame();
+                    sim.post({ResetInput});
                 }
             }
         }
@@ -233,287 +272,178 @@ void Game::processEvents()
         if (event.type == sf::Event::KeyPressed) {
             // 允许按 Esc 关闭窗口
             if (event.key.code == sf::Keyboard::Escape) window.close();
+            // F5 快速存档（内存 + 文件），F9 读档（本次运行没有存过档时从文件读取）
+            if (event.key.code == sf::Keyboard::F5) sim.post({QuickSaveInput});
+            if (event.key.code == sf::Keyboard::F9) sim.post({QuickLoadInput});
+            // F3 开关分阶段耗时面板，F4 导出剖析器缓冲中的事件
+            if (event.key.code == sf::Keyboard::F3) toggleProfiler();
+            if (event.key.code == sf::Keyboard::F4) exportProfile();
         }
     }
 }
 
-// 更新逻辑
-void Game::update(sf::Time deltaTime)
+// 物理线程：在下一个固定步之前处理渲染线程投递的输入
+void Game::applyInput(World& w, const SimulationThread::Input& in)
 {
-    float dt = deltaTime.asSeconds();
-    if (!gameOver) {
-        for (auto& ball : balls)
-            ball.update(dt);
+    switch (in.type) {
+    case DropInput:
+        // 投放到达物理线程之前本局可能已经结束
+        if (w.isGameOver()) break;
+        if (!recordPath.empty())
+            sessionLog.recordDrop(w, in.x, in.y);
+        w.dropNext(in.x, in.y);
+        break;
+    case ResetInput: resetGame(w); break;
+    case QuickSaveInput: quickSave(w); break;
+    case QuickLoadInput: quickLoad(w); break;
+    case ProfilerInput: w.setProfiler(in.x != 0.f ? &profiler : nullptr); break;
     }
+}
 
-    // 先处理碰撞（碰撞可能会产生新球）
-    checkCollisions();
-
-    // 移除已经死亡的球
-    balls.erase(std::remove_if(balls.begin(), balls.end(), [](const Ball& b) { return b.isDead; }), balls.end());
-
-    // 更新分数字符串（如果 font 可用）
-    if (!font.getInfo().family.empty()) {
-        std::ostringstream oss;
-        oss << "Score: " << score;
-        scoreText.setString(oss.str());
+// 同步分数与预览：只在数值变化时重建文字几何
+void Game::refreshHud()
+{
+    // 堆顶接近生命线时把虚线调亮作为警示（堆顶轮廓不含下落中的球，投放时不会闪烁）
+    bool warn = currFrame.dangerHeight < LIFELINE_WARN_MARGIN;
+    if (warn != lifelineWarn) {
+        lifelineWarn = warn;
+        sf::Color lineColor = lifelineColor();
+        for (size_t i = 0; i < lifelineVertices.getVertexCount(); ++i)
+            lifelineVertices[i].color = lineColor;
     }
 
-    // 如果所有球都在地面并速度接近 0，则解锁生成
-    bool anyMoving = false;
-    for (auto& b : balls) {
-        if (!b.isOnGround) { anyMoving = true; break; }
-        // 速度接近 0
-        if (std::abs(b.getVelocity().y) > 1.f) { anyMoving = true; break; }
-    }
-    if (!anyMoving) spawnLocked = false;
-
-    // 检查生命线（只在非 gameOver 时）
-    if (!gameOver) {
-        for (auto &b : balls) {
-            float prevTop = b.getPrevPosition().y - b.getRadius();
-            float curTop = b.getPosition().y - b.getRadius();
-            // 如果上一帧在生命线下而当前帧在生命线上/线上方 -> 被向上推过，立即判死
-            if (prevTop > lifelineY && curTop <= lifelineY) { gameOver = true; break; }
-
-            // 如果当前在/高于生命线，则开始积累在生命线之上的时间
-            if (curTop <= lifelineY) {
-                b.timeAboveLine += dt;
-                // 只有当在生命线上停留超过阈值才判定死亡（避免快速连续生成导致的立即死亡）
-                const float ABOVE_THRESHOLD = 1.5f;
-                if (b.timeAboveLine >= ABOVE_THRESHOLD) { gameOver = true; break; }
-            } else {
-                // 在线下则重置计时
-                b.timeAboveLine = 0.f;
-            }
+    if (font.getInfo().family.empty()) return;
+    if (showProfiler && ++profilerRefresh >= PROFILER_REFRESH_FRAMES) {
+        profilerRefresh = 0;
+        Profiler::Stats stats[Profiler::PHASE_COUNT];
+        profiler.summarize(PROFILER_WINDOW_FRAMES, stats);
+        char buf[640];
+        int len = std::snprintf(buf, sizeof(buf), "ms      mean   p50   p95   max\n");
+        for (int p = 0; p < Profiler::PHASE_COUNT && len < static_cast<int>(sizeof(buf)); ++p) {
+            const Profiler::Stats& st = stats[p];
+            len += std::snprintf(buf + len, sizeof(buf) - len, "%-10s %5.2f %5.2f %5.2f %5.2f\n",
+                                 Profiler::phaseName(static_cast<Profiler::Phase>(p)), st.mean, st.p50, st.p95, st.max);
         }
+        profilerText.setString(buf);
+    }
+    if (currFrame.score != shownScore) {
+        shownScore = currFrame.score;
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "Score: %d", shownScore);
+        scoreText.setString(buf);
+    }
+    int lv = std::max(1, std::min(currFrame.nextSpawnLevel, rules.maxLevel));
+    if (lv != shownPreviewLevel) {
+        shownPreviewLevel = lv;
+        previewShape.setFillColor(colors[lv]);
+        // 在球中央显示等级数字
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "%d", lv);
+        previewText.setString(buf);
+        sf::FloatRect tb = previewText.getLocalBounds();
+        previewText.setOrigin(tb.left + tb.width/2.f, tb.top + tb.height/2.f);
+        previewText.setPosition(previewShape.getPosition());
     }
 }
 
-// 简单碰撞检测：如果两个球重叠，则将其中一个标记为死亡（这是占位逻辑，便于编译和演示）
-void Game::checkCollisions()
+void Game::resetGame(World& w)
 {
-    // 为避免在迭代中直接修改 balls，先收集要生成的新球请求
-    struct SpawnReq { float x; float y; int level; sf::Vector2f vel; };
-    std::vector<SpawnReq> spawns;
-
-    // 优先合并：遍历所有球，如果接触且等级相同则立即合并
-    // 但仅当两球都被“支撑”（supported）时才允许合并——即接触地面或通过一系列接触链条接触地面
-    for (size_t i = 0; i < balls.size(); ++i) {
-        for (size_t j = i + 1; j < balls.size(); ++j) {
-            if (balls[i].isDead || balls[j].isDead) continue;
-            if (balls[i].getLevel() != balls[j].getLevel()) continue;
-            // 只允许在“被支撑”的情况下合并
-            if (!isSupported(i) || !isSupported(j)) continue;
-            sf::Vector2f p1 = balls[i].getPosition();
-            sf::Vector2f p2 = balls[j].getPosition();
-            float dx = p1.x - p2.x;
-            float dy = p1.y - p2.y;
-            float dist2 = dx*dx + dy*dy;
-            float rsum = balls[i].getRadius() + balls[j].getRadius();
-            if (dist2 <= rsum * rsum) {
-                int lvl = balls[i].getLevel();
-                // 仅当当前等级小于最大等级时才合成为更高等级
-                if (lvl >= MAX_LEVEL) continue;
-                int newLevel = std::min(MAX_LEVEL, lvl + 1);
-                sf::Vector2f mid((p1.x + p2.x) / 2.f, (p1.y + p2.y) / 2.f);
-                balls[j].isDead = true;
-                balls[i].isDead = true;
-                // 生成合成球时不要给予强烈向上速度，设置为不动以避免跳起
-                spawns.push_back({mid.x, mid.y - 4.f, newLevel, sf::Vector2f(0.f, 0.f)});
-                score += newLevel * 50;
-            }
-        }
-    }
+    if (!recordPath.empty())
+        sessionLog.recordReset(w);
+    w.reset();
+}
 
-    // 将生成请求转换为实际球（受 MAX_BALLS 限制）
-    for (auto& r : spawns) {
-        if (balls.size() >= MAX_BALLS) break;
-        // 如果生成的是胜利等级，则标记为胜利状态
-        if (r.level >= LEVEL_WIN) {
-            gameWin = true;
-            gameOver = false;
-            if (!font.getInfo().family.empty()) {
-                winText.setFont(font);
-                winText.setCharacterSize(28);
-                winText.setFillColor(sf::Color::White);
-                winText.setString("恭喜你合成出上海大学");
-            }
-            // 仍然生成这个球以便视觉显示
-        }
-        const sf::Texture* sTex = (textures[r.level].getSize().x > 0) ? &textures[r.level] : nullptr;
-        balls.emplace_back(r.x, r.y, r.level, colors[r.level], sTex);
-        balls.back().setVelocity(r.vel);
-        // 初始化生命线相关字段
-        balls.back().prevPosition = balls.back().getPosition();
-        balls.back().timeAboveLine = 0.f;
-        balls.back().wasSpawnedAboveLine = (r.y - balls.back().getRadius() <= lifelineY);
-    }
-    // 更严格的迭代碰撞分离：多次通过以确保没有明显侵入
-    const int separationPasses = 4;
-    for (int pass = 0; pass < separationPasses; ++pass) {
-        for (size_t i = 0; i < balls.size(); ++i) {
-            for (size_t j = i + 1; j < balls.size(); ++j) {
-                if (balls[i].isDead || balls[j].isDead) continue;
-                sf::Vector2f p1 = balls[i].getPosition();
-                sf::Vector2f p2 = balls[j].getPosition();
-                float dx = p2.x - p1.x;
-                float dy = p2.y - p1.y;
-                float dist = std::sqrt(dx*dx + dy*dy);
-                float rsum = balls[i].getRadius() + balls[j].getRadius();
-                if (dist <= 0.0001f) {
-                    // 随机微小偏移，避免完全重合
-                    float jitter = 0.5f;
-                    balls[i].setPosition(p1 + sf::Vector2f(-jitter, -jitter));
-                    balls[j].setPosition(p2 + sf::Vector2f(jitter, jitter));
-                    continue;
-                }
-                if (dist < rsum) {
-                    float overlap = rsum - dist;
-                    sf::Vector2f normal(dx / dist, dy / dist);
-                    float m1 = balls[i].mass;
-                    float m2 = balls[j].mass;
-                    float total = m1 + m2;
-                    // 更强力的分离（确保无穿透），并轻微去除沿法线速度以避免再次侵入
-                    sf::Vector2f moveI = -normal * (overlap * (m2/total) * 1.02f);
-                    sf::Vector2f moveJ = normal * (overlap * (m1/total) * 1.02f);
-                    balls[i].setPosition(balls[i].getPosition() + moveI);
-                    balls[j].setPosition(balls[j].getPosition() + moveJ);
-
-                    // 修正速度，移除沿法线的侵入分量
-                    sf::Vector2f v1 = balls[i].getVelocity();
-                    sf::Vector2f v2 = balls[j].getVelocity();
-                    float vn1 = v1.x * normal.x + v1.y * normal.y;
-                    float vn2 = v2.x * normal.x + v2.y * normal.y;
-                    // 将沿法线的速度减小（防止再次穿透）
-                    v1 -= normal * (vn1 * 0.6f);
-                    v2 -= normal * (vn2 * 0.6f);
-                    balls[i].setVelocity(v1);
-                    balls[j].setVelocity(v2);
-                }
-            }
-        }
+void Game::toggleProfiler()
+{
+    showProfiler = !showProfiler;
+    // 关闭时的解除挂接要等物理线程处理输入后才生效，快速连按时物理线程可能仍在记录；
+    // clear 只移动有效区间的起点，可以与记录并发
+    if (showProfiler) {
+        profiler.clear();
+        profilerRefresh = PROFILER_REFRESH_FRAMES;
+        profilerText.setString("");
     }
+    sim.post({ProfilerInput, showProfiler ? 1.f : 0.f});
+}
 
-    // 墙面约束（左右），并减少水平速度（小的反弹）
-    float winW = static_cast<float>(window.getSize().x);
-    for (auto &b : balls) {
-        sf::Vector2f pos = b.getPosition();
-        float r = b.getRadius();
-        sf::Vector2f vel = b.getVelocity();
-        if (pos.x - r < leftMargin) {
-            pos.x = leftMargin + r;
-            b.setPosition(pos);
-            vel.x = -vel.x * 0.2f; // 小反弹
-            b.setVelocity(vel);
-        } else if (pos.x + r > winW - rightMargin) {
-            pos.x = winW - rightMargin - r;
-            b.setPosition(pos);
-            vel.x = -vel.x * 0.2f;
-            b.setVelocity(vel);
-        }
-    }
+void Game::exportProfile()
+{
+    if (profiler.writeCsv(PROFILE_CSV_PATH) && profiler.writeChromeTrace(PROFILE_TRACE_PATH))
+        std::cout << "profile written to " << PROFILE_CSV_PATH << " and " << PROFILE_TRACE_PATH << std::endl;
+    else
+        std::cerr << "failed to write profile" << std::endl;
 }
 
-void Game::resetGame()
+void Game::quickSave(World& w)
 {
-    balls.clear();
-    score = 0;
-    spawnLocked = false;
-    currentSpawnLevel = 1;
-    gameOver = false;
-    gameWin = false;
+    quickSnapshot.capture(w);
+    if (!quickSnapshot.save(QUICKSAVE_PATH))
+        std::cerr << "failed to write " << QUICKSAVE_PATH << std::endl;
 }
 
-bool Game::isSupported(size_t idx) const
+void Game::quickLoad(World& w)
 {
-    if (idx >= balls.size()) return false;
-    const float EPS = 2.0f;
-    // DFS/BFS 从 idx 向下查找是否可以通过接触链条到达地面
-    std::vector<char> visited(balls.size(), 0);
-    std::vector<size_t> stack;
-    stack.push_back(idx);
-    while (!stack.empty()) {
-        size_t cur = stack.back(); stack.pop_back();
-        if (visited[cur]) continue;
-        visited[cur] = 1;
-        sf::Vector2f p = balls[cur].getPosition();
-        float bottom = p.y + balls[cur].getRadius();
-        // 如果接触或穿透地面则认为被支撑
-        if (bottom >= Ball::FLOOR_Y - EPS) return true;
-        // 向下找接触的球
-        for (size_t k = 0; k < balls.size(); ++k) {
-            if (k == cur) continue;
-            if (visited[k]) continue;
-            sf::Vector2f pk = balls[k].getPosition();
-            float dx = pk.x - p.x;
-            float dy = pk.y - p.y;
-            // 要求对方在当前球下方
-            if (dy <= -0.5f) continue; // pk not below cur
-            float dist = std::sqrt(dx*dx + dy*dy);
-            float rsum = balls[cur].getRadius() + balls[k].getRadius();
-            // 如果两球接触或足够接近（允许少量误差），则认为存在支撑链
-            if (dist <= rsum + EPS) {
-                // 确保 pk 的垂直位置在 cur 之下（即真正位于下方）
-                if (pk.y > p.y - 0.5f) {
-                    stack.push_back(k);
-                }
+    // 输入记录只包含点击与重开，读档后将无法重放，因此记录时不允许读档
+    if (!recordPath.empty()) {
+        std::cerr << "quick load is disabled while recording a session" << std::endl;
+        return;
+    }
+    if (quickSnapshot.empty() && !quickSnapshot.load(QUICKSAVE_PATH)) return;
+    if (!quickSnapshot.restore(w))
+        std::cerr << "snapshot does not match this board, ignored" << std::endl;
+}
+
+// 所有球作为带纹理坐标的四边形（两个三角形）写入同一顶点数组：alpha 为上一帧到当前帧的插值系数
+void Game::buildBallVertices(float alpha)
+{
+    const SimFrame& f = currFrame;
+    ballVertices.resize(f.size() * 6);
+    for (size_t i = 0; i < f.size(); ++i) {
+        int lv = f.level[i];
+        float r = rules.radius[lv];
+        // 上一帧中有同一个球（句柄一致）时在两帧之间插值；新生成的球直接画在当前位置
+        float px = f.x[i], py = f.y[i];
+        std::uint32_t slot = f.handle[i].slot;
+        if (slot < prevIndex.size()) {
+            size_t j = static_cast<size_t>(prevIndex[slot]);
+            if (j < prevFrame.size() && prevFrame.handle[j] == f.handle[i]) {
+                px = prevFrame.x[j] + (f.x[i] - prevFrame.x[j]) * alpha;
+                py = prevFrame.y[j] + (f.y[i] - prevFrame.y[j]) * alpha;
             }
         }
+        // 有贴图时用白色以免混色，否则用白色圆盘染成等级颜色
+        sf::Color tint = atlas.hasImage(lv) ? sf::Color::White : colors[lv];
+        sf::FloatRect uv = atlas.getRect(lv);
+        sf::Vertex* q = &ballVertices[i * 6];
+        sf::Vertex tl(sf::Vector2f(px - r, py - r), tint, sf::Vector2f(uv.left, uv.top));
+        sf::Vertex tr(sf::Vector2f(px + r, py - r), tint, sf::Vector2f(uv.left + uv.width, uv.top));
+        sf::Vertex br(sf::Vector2f(px + r, py + r), tint, sf::Vector2f(uv.left + uv.width, uv.top + uv.height));
+        sf::Vertex bl(sf::Vector2f(px - r, py + r), tint, sf::Vector2f(uv.left, uv.top + uv.height));
+        q[0] = tl; q[1] = tr; q[2] = br;
+        q[3] = tl; q[4] = br; q[5] = bl;
     }
-    return false;
 }
 
 // 渲染画面
 void Game::render()
 {
     window.clear(sf::Color(240, 240, 240));
-    // 绘制生命线（虚线）
-    sf::Color lineColor(180, 30, 30);
-    float startX = 0.f;
-    float endX = static_cast<float>(window.getSize().x);
-    float dashW = 12.f;
-    float gapW = 8.f;
-    for (float x = startX; x < endX; x += (dashW + gapW)) {
-        sf::RectangleShape seg(sf::Vector2f(std::min(dashW, endX - x), 2.f));
-        seg.setPosition(x, lifelineY);
-        seg.setFillColor(lineColor);
-        window.draw(seg);
-    }
-    for (auto& ball : balls)
-        ball.render(window);
+    // 绘制生命线（虚线，几何已缓存）
+    window.draw(lifelineVertices);
+
+    // 所有球一次绘制
+    window.draw(ballVertices, sf::RenderStates(&atlas.getTexture()));
+
     // 绘制分数与当前生成等级（如果 font 可用）
     if (!font.getInfo().family.empty()) {
         // 仅显示分数；在其下方绘制“下一个球”的小预览图标（固定大小，颜色随 nextSpawnLevel 变化）
         window.draw(scoreText);
-
-        const float PREVIEW_R = 12.f;
-        sf::CircleShape preview(PREVIEW_R);
-        preview.setOrigin(PREVIEW_R, PREVIEW_R);
-        // 将预览放在 scoreText 下方（与原来等级文本位置相近）
-        preview.setPosition(8.f + PREVIEW_R, 34.f + PREVIEW_R);
-        int lv = std::max(1, std::min(nextSpawnLevel, MAX_LEVEL));
-        preview.setFillColor(colors[lv]);
-        preview.setOutlineColor(sf::Color::Black);
-        preview.setOutlineThickness(2.f);
-        window.draw(preview);
-
-        // 在球中央显示等级数字（若字体可用）
-        sf::Text lvlText;
-        lvlText.setFont(font);
-        lvlText.setCharacterSize(12);
-        lvlText.setFillColor(sf::Color::Black);
-        lvlText.setString(std::to_string(lv));
-        sf::FloatRect tb = lvlText.getLocalBounds();
-        lvlText.setOrigin(tb.left + tb.width/2.f, tb.top + tb.height/2.f);
-        lvlText.setPosition(preview.getPosition());
-        window.draw(lvlText);
+        window.draw(previewShape);
+        window.draw(previewText);
     }
     // 胜利/失败界面
-    if (gameWin) {
+    if (currFrame.gameWin) {
         // 半透明遮罩
-        sf::RectangleShape overlay(sf::Vector2f((float)window.getSize().x, (float)window.getSize().y));
-        overlay.setFillColor(sf::Color(0,0,0,120));
         window.draw(overlay);
 
         if (!font.getInfo().family.empty()) {
@@ -533,18 +463,11 @@ void Game::render()
             againText.setPosition(againButton.getPosition().x + againButton.getSize().x/2.f, againButton.getPosition().y + againButton.getSize().y/2.f - 4.f);
             window.draw(againText);
         }
-    } else if (gameOver) {
+    } else if (currFrame.gameOver) {
         // 半透明遮罩
-        sf::RectangleShape overlay(sf::Vector2f((float)window.getSize().x, (float)window.getSize().y));
-        overlay.setFillColor(sf::Color(0,0,0,120));
         window.draw(overlay);
 
         if (!font.getInfo().family.empty()) {
-            sf::Text loseText;
-            loseText.setFont(font);
-            loseText.setCharacterSize(36);
-            loseText.setFillColor(sf::Color::White);
-            loseText.setString("You lose");
             // 居中
             sf::FloatRect tb = loseText.getLocalBounds();
             loseText.setOrigin(tb.left + tb.width/2.f, tb.top + tb.height/2.f);
@@ -563,5 +486,36 @@ void Game::render()
         }
     }
 
-    window.display();
-}
\ No newline at end of file
+    if (showProfiler && !font.getInfo().family.empty()) {
+        window.draw(profilerPanel);
+        window.draw(profilerText);
+    }
+}
+
+sf::Color Game::lifelineColor() const
+{
+    return lifelineWarn ? sf::Color(255, 40, 40) : sf::Color(180, 30, 30);
+}
+
+// 按当前窗口宽度生成生命线虚线的顶点（每段一个细长矩形）
+void Game::rebuildLifeline()
+{
+    sf::Color lineColor = lifelineColor();
+    float lifelineY = currFrame.lifelineY;
+    shownLifelineY = lifelineY;
+    float startX = 0.f;
+    float endX = static_cast<float>(window.getSize().x);
+    float dashW = 12.f;
+    float gapW = 8.f;
+    lifelineVertices.setPrimitiveType(sf::Triangles);
+    lifelineVertices.clear();
+    for (float x = startX; x < endX; x += (dashW + gapW)) {
+        float w = std::min(dashW, endX - x);
+        sf::Vertex tl(sf::Vector2f(x, lifelineY), lineColor);
+        sf::Vertex tr(sf::Vector2f(x + w, lifelineY), lineColor);
+        sf::Vertex br(sf::Vector2f(x + w, lifelineY + 2.f), lineColor);
+        sf::Vertex bl(sf::Vector2f(x, lifelineY + 2.f), lineColor);
+        lifelineVertices.append(tl); lifelineVertices.append(tr); lifelineVertices.append(br);
+        lifelineVertices.append(tl); lifelineVertices.append(br); lifelineVertices.append(bl);
+    }
+}
@@ -2,57 +2,120 @@
 
 #include <SFML/Graphics.hpp>
 #include <vector>
-#include "Ball.h"
+#include <string>
+#include <cstdint>
+#include <future>
+#include "World.h"
+#include "SimulationThread.h"
+#include "TextureAtlas.h"
+#include "SessionLog.h"
+#include "Snapshot.h"
+#include "Profiler.h"
 
+// 窗口、输入与渲染层；所有物理与规则都交给 World。
+// World 在独立的物理线程（SimulationThread）上以固定步长推进，本线程只处理窗口事件、投递输入，
+// 并绘制物理线程发布的最新画面状态（在最近两帧之间插值）；标注“物理线程”的成员只在输入处理中访问
 class Game {
 public:
-	Game();
+	// rules 为本局规则集（决定窗口尺寸）；seed 为本局随机种子；
+	// recordPath 非空时记录本局输入，退出时写入该文件（可用 --replay 重放）
+	Game(const RuleSet& rules, std::uint64_t seed, const std::string& recordPath = "");
+	// 先停下物理线程（handler 引用的记录、存档与剖析器成员在 sim 之后声明，会先析构）
+	~Game();
 	void run();
+	// 资源全部加载完成后输出启动耗时（冷启动 / 由图集缓存热启动）并退出
+	void setStartupReport(bool on) { startupReport = on; }
 
 private:
+	// 投递给物理线程的输入类型
+	enum InputType : std::uint8_t { DropInput, ResetInput, QuickSaveInput, QuickLoadInput, ProfilerInput };
+
 	void processEvents();
-	void update(sf::Time deltaTime);
+	// 物理线程：处理一条输入
+	void applyInput(World& w, const SimulationThread::Input& in);
+	// 取物理线程的最新一帧；有新帧时上一帧留作插值起点
+	bool acquireFrame();
+	float interpolationAlpha() const;
+	void buildBallVertices(float alpha);
+	void refreshHud();
 	void render();
 	void loadResources();
-	void spawnBall(float x, float y, int level);
-	void checkCollisions();
-	bool isSupported(size_t idx) const;
-	void resetGame();
+	static std::vector<char> readFontFile();
+	void applyFont();
+	void pollAssets();
+	void resetGame(World& w);
+	void quickSave(World& w);
+	void quickLoad(World& w);
+	void toggleProfiler();
+	void exportProfile();
+	void rebuildLifeline();
+	sf::Color lifelineColor() const;
 
 private:
+	// 启动计时（在窗口之前构造，包含创建窗口的耗时）
+	sf::Clock startupClock;
 	sf::RenderWindow window;
-	std::vector<Ball> balls;
-	sf::Texture textures[12];
-	sf::Color colors[12];
-
-	// UI / 游戏状态
-	sf::Font font;
-	sf::Text scoreText;
-	int score = 0;
+	World world;
+	const RuleSet& rules;
+	// 固定步长模拟：每步 1/60 秒，子步数与单次最大补步数可调
+	static constexpr float FIXED_STEP = 1.f / 60.f;
+	static constexpr int SUBSTEPS = 1;
+	static constexpr int MAX_CATCH_UP_STEPS = 5;
+	SimulationThread sim;
+	// 最近两帧画面状态（按球数上限预留，复制时不分配）；prevIndex 按句柄槽位查上一帧中同一个球的下标
+	SimFrame prevFrame;
+	SimFrame currFrame;
+	std::vector<std::int32_t> prevIndex;
+	// 所有等级的贴图拼成一张图集，全部球写进同一个顶点数组，一次 draw 完成
+	TextureAtlas atlas;
+	sf::Color colors[RuleSet::MAX_LEVELS];
+	sf::VertexArray ballVertices;
+	// 生命线虚线几何缓存：只在窗口尺寸或生命线位置变化时重建
+	sf::VertexArray lifelineVertices;
+	float shownLifelineY = 0.f;
+	// 堆顶距生命线不足该距离（像素）时高亮生命线
+	static constexpr float LIFELINE_WARN_MARGIN = 40.f;
+	bool lifelineWarn = false;
 
-	// 游戏限制
-	const size_t MAX_BALLS = 200;
-	// 控制生成：当一个或多个球未稳定时禁止产生新的球
-	bool spawnLocked = false;
+	// 输入记录（recordPath 为空时不记录；物理线程）
+	std::string recordPath;
+	SessionLog sessionLog;
 
-	// 当前选择生成的等级（1/2/3），3 级需要解锁
-	int currentSpawnLevel = 1;
-	const int LEVEL3_UNLOCK_SCORE = 1000; // 解锁第3级所需分数，可调整
-	// 现在始终随机生成 1/2/3；第3级受解锁分数限制
-	bool random23Mode = true; // 保留字段以兼容旧逻辑但默认开启（实际我们会随机 1-3）
+	// 快速存档（F5 / F9；物理线程）
+	static constexpr const char* QUICKSAVE_PATH = "quicksave.sbss";
+	Snapshot quickSnapshot;
 
-	// 最大等级（现在扩展为 10 级）
-	const int MAX_LEVEL = 10;
+	// 字体异步读入：fontData 在字体的整个生命周期内保持不变（sf::Font 直接引用这块内存）
+	std::future<std::vector<char>> fontFuture;
+	std::vector<char> fontData;
+	// 启动耗时（毫秒，-1 表示尚未完成）
+	bool startupReport = false;
+	std::int32_t firstFrameMs = -1;
+	std::int32_t texturesReadyMs = -1;
+	std::int32_t fontReadyMs = -1;
 
-	// 下一个将要生成的等级（用于 UI 预览）
-	int nextSpawnLevel = 1;
-	void pickNextSpawnLevel();
+	// UI / 游戏状态（文字与图形常驻复用，只在显示内容变化时更新）
+	sf::Font font;
+	sf::Text scoreText;
+	int shownScore = -1;
+	sf::CircleShape previewShape;
+	sf::Text previewText;
+	int shownPreviewLevel = 0;
+	sf::RectangleShape overlay;
+	sf::Text loseText;
+	// 本帧是否处理了玩家输入（调试构建中用于判定稳定帧）
+	bool inputThisFrame = false;
 
-	// 生命线（虚线）Y 坐标（相对于窗口顶部）
-	float lifelineY = 240.f; // 将生命线下移靠近中部/下方，使更容易触发 game over
-	bool gameOver = false;
-	bool gameWin = false;
-	const int LEVEL_WIN = MAX_LEVEL; // 合成到该等级视为胜利（现在为 10 级）
+	// 分阶段耗时面板（F3）：每 PROFILER_REFRESH_FRAMES 帧按最近 PROFILER_WINDOW_FRAMES 帧刷新一次
+	static constexpr size_t PROFILER_WINDOW_FRAMES = 120;
+	static constexpr int PROFILER_REFRESH_FRAMES = 15;
+	static constexpr const char* PROFILE_CSV_PATH = "profile.csv";
+	static constexpr const char* PROFILE_TRACE_PATH = "profile.json";
+	Profiler profiler;
+	bool showProfiler = false;
+	int profilerRefresh = 0;
+	sf::RectangleShape profilerPanel;
+	sf::Text profilerText;
 
 	// 胜利界面文本
 	sf::Text winText;
@@ -60,8 +123,4 @@ private:
 	// 游戏结束界面元素
 	sf::RectangleShape againButton;
 	sf::Text againText;
-
-	// 容器边界（留白 margin）
-	float leftMargin = 20.f;
-	float rightMargin = 20.f;
-};
\ No newline at end of file
+};
@@ -0,0 +1,64 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_POSIX 1
+#endif
+
+bool MappedFile::open(const std::string& path)
+{
+	close();
+#ifdef MAPPED_FILE_POSIX
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd); // 映射建立后即可关闭描述符
+	if (p == MAP_FAILED) return false;
+	ptr = static_cast<const unsigned char*>(p);
+	length = static_cast<size_t>(st.st_size);
+	mapped = true;
+	return true;
+#else
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) return false;
+	std::streamsize size = in.tellg();
+	if (size <= 0) return false;
+	in.seekg(0);
+	buffer.resize(static_cast<size_t>(size));
+	if (!in.read(reinterpret_cast<char*>(buffer.data()), size)) {
+		buffer.clear();
+		return false;
+	}
+	ptr = buffer.data();
+	length = buffer.size();
+	return true;
+#endif
+}
+
+void MappedFile::close()
+{
+#ifdef MAPPED_FILE_POSIX
+	if (mapped) ::munmap(const_cast<unsigned char*>(ptr), length);
+#endif
+	mapped = false;
+	ptr = nullptr;
+	length = 0;
+	buffer.clear();
+	buffer.shrink_to_fit();
+}
+
+void MappedFile::adviseSequential() const
+{
+#ifdef MAPPED_FILE_POSIX
+	if (mapped) ::madvise(const_cast<unsigned char*>(ptr), length, MADV_SEQUENTIAL);
+#endif
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// 只读文件映射：POSIX 上用 mmap 直接映射文件内容（按需分页，不拷贝），
+// 其他平台退化为一次性读入内存。用于快照与资源缓存这类“文件布局即内存布局”的数据。
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile() { close(); }
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const { return ptr != nullptr; }
+	const unsigned char* data() const { return ptr; }
+	size_t size() const { return length; }
+	// 提示内核将按顺序读取（加大预读、读过的页可以尽早回收），用于顺序扫描很大的文件；不支持时什么也不做
+	void adviseSequential() const;
+
+private:
+	const unsigned char* ptr = nullptr;
+	size_t length = 0;
+	bool mapped = false;
+	std::vector<unsigned char> buffer; // 不支持映射时的读入缓冲
+};
@@ -0,0 +1,522 @@
+#include "PhysicsKernels.h"
+#include "Ball.h"
+#include "BallStore.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// 禁止编译器把 a * b + c 融合为 FMA（-march 开启 FMA 时 GCC 默认会融合）：融合改变舍入，
+// 标量参考实现与向量内核就不再逐位一致，不同编译选项的构建之间也无法互相重放
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SBS_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// GCC/Clang 需要为单个函数开启 AVX2 指令；MSVC 允许直接使用内建函数
+#if defined(SBS_X86) && (defined(__GNUC__) || defined(__clang__))
+#define SBS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SBS_TARGET_AVX2
+#endif
+
+// ---------------- 标量参考实现 ----------------
+
+// 分离求解（与原 checkCollisions 中的逐对处理完全相同）
+static void solveScalar(BallStore& b, const int* pa, const int* pb, size_t count)
+{
+	for (size_t k = 0; k < count; ++k) {
+		const size_t i = static_cast<size_t>(pa[k]);
+		const size_t j = static_cast<size_t>(pb[k]);
+		float dx = b.x[j] - b.x[i];
+		float dy = b.y[j] - b.y[i];
+		float dist = std::sqrt(dx*dx + dy*dy);
+		float rsum = b.radius[i] + b.radius[j];
+		if (dist <= 0.0001f) {
+			// 随机微小偏移，避免完全重合
+			float jitter = 0.5f;
+			b.x[i] -= jitter; b.y[i] -= jitter;
+			b.x[j] += jitter; b.y[j] += jitter;
+			continue;
+		}
+		if (dist < rsum) {
+			float overlap = rsum - dist;
+			float nx = dx / dist;
+			float ny = dy / dist;
+			float m1 = b.mass[i];
+			float m2 = b.mass[j];
+			float total = m1 + m2;
+			// 更强力的分离（确保无穿透），并轻微去除沿法线速度以避免再次侵入
+			float pushI = overlap * (m2/total) * 1.02f;
+			float pushJ = overlap * (m1/total) * 1.02f;
+			b.x[i] -= nx * pushI; b.y[i] -= ny * pushI;
+			b.x[j] += nx * pushJ; b.y[j] += ny * pushJ;
+
+			// 修正速度，移除沿法线的侵入分量（将沿法线的速度减小，防止再次穿透）
+			float vn1 = b.vx[i] * nx + b.vy[i] * ny;
+			float vn2 = b.vx[j] * nx + b.vy[j] * ny;
+			b.vx[i] -= nx * (vn1 * 0.6f); b.vy[i] -= ny * (vn1 * 0.6f);
+			b.vx[j] -= nx * (vn2 * 0.6f); b.vy[j] -= ny * (vn2 * 0.6f);
+		}
+	}
+}
+
+#ifdef SBS_X86
+
+// 按 mask 的各位设置/清除 ON_GROUND 标志
+static inline void writeGroundFlags(BallStore& b, size_t i, int lanes, int mask)
+{
+	for (int l = 0; l < lanes; ++l)
+		b.setFlag(i + l, BallStore::ON_GROUND, (mask >> l) & 1);
+}
+
+// ---------------- SSE（4 路） ----------------
+// 只使用 SSE2 指令（x86-64 基线），条件选择用 and/andnot/or 组合
+
+static inline __m128 selectSSE(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+template <const RuleSet& R>
+static void integrateSSE(BallStore& b, size_t begin, size_t end, float dt)
+{
+	const __m128 vdt = _mm_set1_ps(dt);
+	const __m128 gdt = _mm_set1_ps(R.gravity * dt);
+	const __m128 floorY = _mm_set1_ps(R.floorY);
+	const __m128 rest = _mm_set1_ps(R.restitution);
+	const __m128 dec = _mm_set1_ps(R.friction * dt);
+	const __m128 settle = _mm_set1_ps(30.f);
+	const __m128 tiny = _mm_set1_ps(0.01f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 minusOne = _mm_set1_ps(-1.f);
+	const __m128 signBit = _mm_set1_ps(-0.f);
+
+	size_t i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 x = _mm_loadu_ps(&b.x[i]);
+		__m128 y = _mm_loadu_ps(&b.y[i]);
+		__m128 vx = _mm_loadu_ps(&b.vx[i]);
+		__m128 vy = _mm_loadu_ps(&b.vy[i]);
+		__m128 r = _mm_loadu_ps(&b.radius[i]);
+		_mm_storeu_ps(&b.prevX[i], x);
+		_mm_storeu_ps(&b.prevY[i], y);
+		_mm_storeu_ps(&b.age[i], _mm_add_ps(_mm_loadu_ps(&b.age[i]), vdt));
+
+		vy = _mm_add_ps(vy, gdt);
+		x = _mm_add_ps(x, _mm_mul_ps(vx, vdt));
+		__m128 py = _mm_add_ps(y, _mm_mul_ps(vy, vdt));
+
+		// 触地：夹到地面并反弹，反弹速度足够小则视为停在地面
+		__m128 hit = _mm_cmpge_ps(_mm_add_ps(py, r), floorY);
+		py = selectSSE(hit, _mm_sub_ps(floorY, r), py);
+		vy = selectSSE(hit, _mm_mul_ps(_mm_xor_ps(vy, signBit), rest), vy);
+		__m128 ground = _mm_and_ps(hit, _mm_cmplt_ps(_mm_andnot_ps(signBit, vy), settle));
+		vy = selectSSE(ground, zero, vy);
+
+		// 地面摩擦
+		__m128 sign = selectSSE(_mm_cmpge_ps(vx, zero), one, minusOne);
+		__m128 fric = selectSSE(_mm_cmple_ps(_mm_andnot_ps(signBit, vx), dec), zero, _mm_sub_ps(vx, _mm_mul_ps(sign, dec)));
+		vx = selectSSE(ground, fric, vx);
+		vx = selectSSE(_mm_cmplt_ps(_mm_andnot_ps(signBit, vx), tiny), zero, vx);
+
+		_mm_storeu_ps(&b.x[i], x);
+		_mm_storeu_ps(&b.y[i], py);
+		_mm_storeu_ps(&b.vx[i], vx);
+		_mm_storeu_ps(&b.vy[i], vy);
+		writeGroundFlags(b, i, 4, _mm_movemask_ps(ground));
+	}
+	Ball::integrate<R>(b, i, end, dt);
+}
+
+static void solveSSE(BallStore& b, const int* pa, const int* pb, size_t count)
+{
+	const __m128 eps = _mm_set1_ps(0.0001f);
+	const __m128 jitter = _mm_set1_ps(0.5f);
+	const __m128 push = _mm_set1_ps(1.02f);
+	const __m128 damp = _mm_set1_ps(0.6f);
+
+	size_t k = 0;
+	for (; k + 4 <= count; k += 4) {
+		const int* a = pa + k;
+		const int* c = pb + k;
+		__m128 xi = _mm_setr_ps(b.x[a[0]], b.x[a[1]], b.x[a[2]], b.x[a[3]]);
+		__m128 yi = _mm_setr_ps(b.y[a[0]], b.y[a[1]], b.y[a[2]], b.y[a[3]]);
+		__m128 xj = _mm_setr_ps(b.x[c[0]], b.x[c[1]], b.x[c[2]], b.x[c[3]]);
+		__m128 yj = _mm_setr_ps(b.y[c[0]], b.y[c[1]], b.y[c[2]], b.y[c[3]]);
+		__m128 ri = _mm_setr_ps(b.radius[a[0]], b.radius[a[1]], b.radius[a[2]], b.radius[a[3]]);
+		__m128 rj = _mm_setr_ps(b.radius[c[0]], b.radius[c[1]], b.radius[c[2]], b.radius[c[3]]);
+
+		__m128 dx = _mm_sub_ps(xj, xi);
+		__m128 dy = _mm_sub_ps(yj, yi);
+		__m128 dist = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		__m128 rsum = _mm_add_ps(ri, rj);
+		__m128 coincide = _mm_cmple_ps(dist, eps);
+		__m128 hit = _mm_andnot_ps(coincide, _mm_cmplt_ps(dist, rsum));
+		int coincideBits = _mm_movemask_ps(coincide);
+		int hitBits = _mm_movemask_ps(hit);
+		if ((coincideBits | hitBits) == 0) continue;
+
+		__m128 vxi = _mm_setr_ps(b.vx[a[0]], b.vx[a[1]], b.vx[a[2]], b.vx[a[3]]);
+		__m128 vyi = _mm_setr_ps(b.vy[a[0]], b.vy[a[1]], b.vy[a[2]], b.vy[a[3]]);
+		__m128 vxj = _mm_setr_ps(b.vx[c[0]], b.vx[c[1]], b.vx[c[2]], b.vx[c[3]]);
+		__m128 vyj = _mm_setr_ps(b.vy[c[0]], b.vy[c[1]], b.vy[c[2]], b.vy[c[3]]);
+		__m128 m1 = _mm_setr_ps(b.mass[a[0]], b.mass[a[1]], b.mass[a[2]], b.mass[a[3]]);
+		__m128 m2 = _mm_setr_ps(b.mass[c[0]], b.mass[c[1]], b.mass[c[2]], b.mass[c[3]]);
+
+		__m128 overlap = _mm_sub_ps(rsum, dist);
+		__m128 nx = _mm_div_ps(dx, dist);
+		__m128 ny = _mm_div_ps(dy, dist);
+		__m128 total = _mm_add_ps(m1, m2);
+		__m128 pushI = _mm_mul_ps(_mm_mul_ps(overlap, _mm_div_ps(m2, total)), push);
+		__m128 pushJ = _mm_mul_ps(_mm_mul_ps(overlap, _mm_div_ps(m1, total)), push);
+		__m128 vn1 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vxi, nx), _mm_mul_ps(vyi, ny)), damp);
+		__m128 vn2 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(vxj, nx), _mm_mul_ps(vyj, ny)), damp);
+
+		// 重合的球对只做抖动，重叠的球对做推开与法向速度衰减，其余保持不变
+		__m128 jit = _mm_and_ps(coincide, jitter);
+		xi = _mm_sub_ps(selectSSE(hit, _mm_sub_ps(xi, _mm_mul_ps(nx, pushI)), xi), jit);
+		yi = _mm_sub_ps(selectSSE(hit, _mm_sub_ps(yi, _mm_mul_ps(ny, pushI)), yi), jit);
+		xj = _mm_add_ps(selectSSE(hit, _mm_add_ps(xj, _mm_mul_ps(nx, pushJ)), xj), jit);
+		yj = _mm_add_ps(selectSSE(hit, _mm_add_ps(yj, _mm_mul_ps(ny, pushJ)), yj), jit);
+		vxi = selectSSE(hit, _mm_sub_ps(vxi, _mm_mul_ps(nx, vn1)), vxi);
+		vyi = selectSSE(hit, _mm_sub_ps(vyi, _mm_mul_ps(ny, vn1)), vyi);
+		vxj = selectSSE(hit, _mm_sub_ps(vxj, _mm_mul_ps(nx, vn2)), vxj);
+		vyj = selectSSE(hit, _mm_sub_ps(vyj, _mm_mul_ps(ny, vn2)), vyj);
+
+		alignas(16) float out[8][4];
+		_mm_store_ps(out[0], xi); _mm_store_ps(out[1], yi);
+		_mm_store_ps(out[2], xj); _mm_store_ps(out[3], yj);
+		_mm_store_ps(out[4], vxi); _mm_store_ps(out[5], vyi);
+		_mm_store_ps(out[6], vxj); _mm_store_ps(out[7], vyj);
+		const int touched = coincideBits | hitBits;
+		for (int l = 0; l < 4; ++l) {
+			if (!((touched >> l) & 1)) continue;
+			b.x[a[l]] = out[0][l]; b.y[a[l]] = out[1][l];
+			b.x[c[l]] = out[2][l]; b.y[c[l]] = out[3][l];
+			b.vx[a[l]] = out[4][l]; b.vy[a[l]] = out[5][l];
+			b.vx[c[l]] = out[6][l]; b.vy[c[l]] = out[7][l];
+		}
+	}
+	solveScalar(b, pa + k, pb + k, count - k);
+}
+
+// ---------------- AVX2（8 路） ----------------
+
+template <const RuleSet& R>
+SBS_TARGET_AVX2
+static void integrateAVX2(BallStore& b, size_t begin, size_t end, float dt)
+{
+	const __m256 vdt = _mm256_set1_ps(dt);
+	const __m256 gdt = _mm256_set1_ps(R.gravity * dt);
+	const __m256 floorY = _mm256_set1_ps(R.floorY);
+	const __m256 rest = _mm256_set1_ps(R.restitution);
+	const __m256 dec = _mm256_set1_ps(R.friction * dt);
+	const __m256 settle = _mm256_set1_ps(30.f);
+	const __m256 tiny = _mm256_set1_ps(0.01f);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 one = _mm256_set1_ps(1.f);
+	const __m256 minusOne = _mm256_set1_ps(-1.f);
+	const __m256 signBit = _mm256_set1_ps(-0.f);
+
+	size_t i = begin;
+	for (; i + 8 <= end; i += 8) {
+		__m256 x = _mm256_loadu_ps(&b.x[i]);
+		__m256 y = _mm256_loadu_ps(&b.y[i]);
+		__m256 vx = _mm256_loadu_ps(&b.vx[i]);
+		__m256 vy = _mm256_loadu_ps(&b.vy[i]);
+		__m256 r = _mm256_loadu_ps(&b.radius[i]);
+		_mm256_storeu_ps(&b.prevX[i], x);
+		_mm256_storeu_ps(&b.prevY[i], y);
+		_mm256_storeu_ps(&b.age[i], _mm256_add_ps(_mm256_loadu_ps(&b.age[i]), vdt));
+
+		vy = _mm256_add_ps(vy, gdt);
+		x = _mm256_add_ps(x, _mm256_mul_ps(vx, vdt));
+		__m256 py = _mm256_add_ps(y, _mm256_mul_ps(vy, vdt));
+
+		__m256 hit = _mm256_cmp_ps(_mm256_add_ps(py, r), floorY, _CMP_GE_OQ);
+		py = _mm256_blendv_ps(py, _mm256_sub_ps(floorY, r), hit);
+		vy = _mm256_blendv_ps(vy, _mm256_mul_ps(_mm256_xor_ps(vy, signBit), rest), hit);
+		__m256 ground = _mm256_and_ps(hit, _mm256_cmp_ps(_mm256_andnot_ps(signBit, vy), settle, _CMP_LT_OQ));
+		vy = _mm256_blendv_ps(vy, zero, ground);
+
+		__m256 sign = _mm256_blendv_ps(minusOne, one, _mm256_cmp_ps(vx, zero, _CMP_GE_OQ));
+		__m256 stop = _mm256_cmp_ps(_mm256_andnot_ps(signBit, vx), dec, _CMP_LE_OQ);
+		__m256 fric = _mm256_blendv_ps(_mm256_sub_ps(vx, _mm256_mul_ps(sign, dec)), zero, stop);
+		vx = _mm256_blendv_ps(vx, fric, ground);
+		vx = _mm256_blendv_ps(vx, zero, _mm256_cmp_ps(_mm256_andnot_ps(signBit, vx), tiny, _CMP_LT_OQ));
+
+		_mm256_storeu_ps(&b.x[i], x);
+		_mm256_storeu_ps(&b.y[i], py);
+		_mm256_storeu_ps(&b.vx[i], vx);
+		_mm256_storeu_ps(&b.vy[i], vy);
+		writeGroundFlags(b, i, 8, _mm256_movemask_ps(ground));
+	}
+	Ball::integrate<R>(b, i, end, dt);
+}
+
+SBS_TARGET_AVX2
+static void solveAVX2(BallStore& b, const int* pa, const int* pb, size_t count)
+{
+	const __m256 eps = _mm256_set1_ps(0.0001f);
+	const __m256 jitter = _mm256_set1_ps(0.5f);
+	const __m256 push = _mm256_set1_ps(1.02f);
+	const __m256 damp = _mm256_set1_ps(0.6f);
+	const float* X = b.x.data();
+	const float* Y = b.y.data();
+	const float* R = b.radius.data();
+
+	size_t k = 0;
+	for (; k + 8 <= count; k += 8) {
+		const int* a = pa + k;
+		const int* c = pb + k;
+		const __m256i ia = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+		const __m256i ic = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c));
+		__m256 xi = _mm256_i32gather_ps(X, ia, 4);
+		__m256 yi = _mm256_i32gather_ps(Y, ia, 4);
+		__m256 xj = _mm256_i32gather_ps(X, ic, 4);
+		__m256 yj = _mm256_i32gather_ps(Y, ic, 4);
+		__m256 rsum = _mm256_add_ps(_mm256_i32gather_ps(R, ia, 4), _mm256_i32gather_ps(R, ic, 4));
+
+		__m256 dx = _mm256_sub_ps(xj, xi);
+		__m256 dy = _mm256_sub_ps(yj, yi);
+		__m256 dist = _mm256_sqrt_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)));
+		__m256 coincide = _mm256_cmp_ps(dist, eps, _CMP_LE_OQ);
+		__m256 hit = _mm256_andnot_ps(coincide, _mm256_cmp_ps(dist, rsum, _CMP_LT_OQ));
+		const int coincideBits = _mm256_movemask_ps(coincide);
+		const int hitBits = _mm256_movemask_ps(hit);
+		// 大多数候选对并不重叠，整批跳过
+		if ((coincideBits | hitBits) == 0) continue;
+
+		__m256 vxi = _mm256_i32gather_ps(b.vx.data(), ia, 4);
+		__m256 vyi = _mm256_i32gather_ps(b.vy.data(), ia, 4);
+		__m256 vxj = _mm256_i32gather_ps(b.vx.data(), ic, 4);
+		__m256 vyj = _mm256_i32gather_ps(b.vy.data(), ic, 4);
+		__m256 m1 = _mm256_i32gather_ps(b.mass.data(), ia, 4);
+		__m256 m2 = _mm256_i32gather_ps(b.mass.data(), ic, 4);
+
+		__m256 overlap = _mm256_sub_ps(rsum, dist);
+		__m256 nx = _mm256_div_ps(dx, dist);
+		__m256 ny = _mm256_div_ps(dy, dist);
+		__m256 total = _mm256_add_ps(m1, m2);
+		__m256 pushI = _mm256_mul_ps(_mm256_mul_ps(overlap, _mm256_div_ps(m2, total)), push);
+		__m256 pushJ = _mm256_mul_ps(_mm256_mul_ps(overlap, _mm256_div_ps(m1, total)), push);
+		__m256 vn1 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(vxi, nx), _mm256_mul_ps(vyi, ny)), damp);
+		__m256 vn2 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(vxj, nx), _mm256_mul_ps(vyj, ny)), damp);
+
+		__m256 jit = _mm256_and_ps(coincide, jitter);
+		xi = _mm256_sub_ps(_mm256_blendv_ps(xi, _mm256_sub_ps(xi, _mm256_mul_ps(nx, pushI)), hit), jit);
+		yi = _mm256_sub_ps(_mm256_blendv_ps(yi, _mm256_sub_ps(yi, _mm256_mul_ps(ny, pushI)), hit), jit);
+		xj = _mm256_add_ps(_mm256_blendv_ps(xj, _mm256_add_ps(xj, _mm256_mul_ps(nx, pushJ)), hit), jit);
+		yj = _mm256_add_ps(_mm256_blendv_ps(yj, _mm256_add_ps(yj, _mm256_mul_ps(ny, pushJ)), hit), jit);
+		vxi = _mm256_blendv_ps(vxi, _mm256_sub_ps(vxi, _mm256_mul_ps(nx, vn1)), hit);
+		vyi = _mm256_blendv_ps(vyi, _mm256_sub_ps(vyi, _mm256_mul_ps(ny, vn1)), hit);
+		vxj = _mm256_blendv_ps(vxj, _mm256_sub_ps(vxj, _mm256_mul_ps(nx, vn2)), hit);
+		vyj = _mm256_blendv_ps(vyj, _mm256_sub_ps(vyj, _mm256_mul_ps(ny, vn2)), hit);
+
+		// AVX2 没有 scatter：写回临时数组后只回填发生变化的球对
+		alignas(32) float out[8][8];
+		_mm256_store_ps(out[0], xi); _mm256_store_ps(out[1], yi);
+		_mm256_store_ps(out[2], xj); _mm256_store_ps(out[3], yj);
+		_mm256_store_ps(out[4], vxi); _mm256_store_ps(out[5], vyi);
+		_mm256_store_ps(out[6], vxj); _mm256_store_ps(out[7], vyj);
+		const int touched = coincideBits | hitBits;
+		for (int l = 0; l < 8; ++l) {
+			if (!((touched >> l) & 1)) continue;
+			b.x[a[l]] = out[0][l]; b.y[a[l]] = out[1][l];
+			b.x[c[l]] = out[2][l]; b.y[c[l]] = out[3][l];
+			b.vx[a[l]] = out[4][l]; b.vy[a[l]] = out[5][l];
+			b.vx[c[l]] = out[6][l]; b.vy[c[l]] = out[7][l];
+		}
+	}
+	solveScalar(b, pa + k, pb + k, count - k);
+}
+
+#endif // SBS_X86
+
+// ---------------- 运行时选择 ----------------
+
+// 每个规则集一张内核表：积分内核按规则集实例化，分离求解与规则无关
+template <const RuleSet& R>
+struct RuleKernels {
+	static const PhysicsKernels table[];
+};
+
+template <const RuleSet& R>
+const PhysicsKernels RuleKernels<R>::table[] = {
+	{ SimdLevel::Scalar, "scalar", &Ball::integrate<R>, &solveScalar },
+#ifdef SBS_X86
+	{ SimdLevel::SSE, "sse", &integrateSSE<R>, &solveSSE },
+	{ SimdLevel::AVX2, "avx2", &integrateAVX2<R>, &solveAVX2 },
+#endif
+};
+
+#ifdef SBS_X86
+static constexpr size_t KERNEL_COUNT = 3;
+#else
+static constexpr size_t KERNEL_COUNT = 1;
+#endif
+
+// 规则集对应的内核表（只在 World 构造与切换指令集时查找一次）；未登记的规则集返回 nullptr
+static const PhysicsKernels* kernelTable(const RuleSet& rules)
+{
+#define SBS_KERNEL_TABLE(R) if (&rules == &Rules::R) return RuleKernels<Rules::R>::table;
+	SBS_RULE_SETS(SBS_KERNEL_TABLE)
+#undef SBS_KERNEL_TABLE
+	return nullptr;
+}
+
+SimdLevel PhysicsKernels::detect()
+{
+#ifdef SBS_X86
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+#elif defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] >= 7) {
+		__cpuidex(info, 7, 0);
+		bool avx2 = (info[1] & (1 << 5)) != 0;
+		__cpuid(info, 1);
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		if (avx2 && osxsave && (_xgetbv(0) & 6) == 6) return SimdLevel::AVX2;
+	}
+#endif
+	return SimdLevel::SSE; // x86-64 基线即包含 SSE2
+#else
+	return SimdLevel::Scalar;
+#endif
+}
+
+const PhysicsKernels& PhysicsKernels::get(SimdLevel level)
+{
+	return get(level, Rules::CLASSIC);
+}
+
+const PhysicsKernels& PhysicsKernels::get(SimdLevel level, const RuleSet& rules)
+{
+	const SimdLevel supported = detect();
+	if (static_cast<int>(level) > static_cast<int>(supported)) level = supported;
+	const PhysicsKernels* table = kernelTable(rules);
+	assert(table && "rule set must be listed in SBS_RULE_SETS");
+	if (!table) table = RuleKernels<Rules::CLASSIC>::table;
+	for (size_t k = 0; k < KERNEL_COUNT; ++k)
+		if (table[k].level == level) return table[k];
+	return table[0];
+}
+
+const PhysicsKernels& PhysicsKernels::best()
+{
+	return best(Rules::CLASSIC);
+}
+
+const PhysicsKernels& PhysicsKernels::best(const RuleSet& rules)
+{
+	static const SimdLevel level = detect();
+	return get(level, rules);
+}
+
+// ---------------- 自检 ----------------
+
+// 自检用的小型线性同余随机数（与游戏逻辑的随机数互不干扰）
+static float selfTestRand(std::uint32_t& state, float lo, float hi)
+{
+	state = state * 1664525u + 1013904223u;
+	return lo + (hi - lo) * static_cast<float>(state >> 8) / 16777216.f;
+}
+
+// 生成贴近地面、彼此大量重叠的随机球堆
+static void makeSelfTestStore(BallStore& b, size_t n, std::uint32_t seed, const RuleSet& rules)
+{
+	b.clear();
+	const float maxLevel = static_cast<float>(rules.maxLevel) - 0.01f;
+	for (size_t i = 0; i < n; ++i) {
+		int lvl = 1 + static_cast<int>(selfTestRand(seed, 0.f, maxLevel));
+		size_t k = b.add(selfTestRand(seed, 20.f, rules.width - 20.f),
+			selfTestRand(seed, rules.floorY - 300.f, rules.floorY), lvl, rules);
+		b.vx[k] = selfTestRand(seed, -200.f, 200.f);
+		b.vy[k] = selfTestRand(seed, -400.f, 400.f);
+		// 一部分球静止，覆盖地面摩擦与阈值分支
+		if (i % 5 == 0) { b.vx[k] = 0.f; b.vy[k] = 0.f; }
+		if (i % 7 == 0) b.vx[k] = 0.005f;
+	}
+}
+
+// 逐位比较（不是容差比较）：回放依赖向量版本与标量版本的结果完全相同
+static bool sameArray(const std::vector<float>& a, const std::vector<float>& b)
+{
+	return a.size() == b.size()
+		&& (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0);
+}
+
+static bool sameState(const BallStore& a, const BallStore& b)
+{
+	return sameArray(a.x, b.x) && sameArray(a.y, b.y) && sameArray(a.vx, b.vx) && sameArray(a.vy, b.vy)
+		&& sameArray(a.prevX, b.prevX) && sameArray(a.prevY, b.prevY) && sameArray(a.age, b.age)
+		&& a.flags == b.flags;
+}
+
+bool PhysicsKernels::selfTest(std::ostream& out)
+{
+	const size_t N = 1003; // 非 8 的倍数，覆盖尾部标量路径
+	const float dt = 1.f / 60.f;
+	bool allOk = true;
+
+	// 互不共享球的随机球对（模拟一个着色批次），包含若干完全重合的球对
+	std::vector<int> pa, pb;
+	std::uint32_t seed = 12345u;
+	std::vector<int> order(N);
+	for (size_t i = 0; i < N; ++i) order[i] = static_cast<int>(i);
+	for (size_t i = N - 1; i > 0; --i) {
+		size_t j = static_cast<size_t>(selfTestRand(seed, 0.f, static_cast<float>(i) + 0.999f));
+		std::swap(order[i], order[j]);
+	}
+	for (size_t i = 0; i + 1 < N; i += 2) { pa.push_back(order[i]); pb.push_back(order[i + 1]); }
+
+	out << "simd self-test (cpu: " << get(detect()).name << ")\n";
+	for (const RuleSet* rules : Rules::ALL) {
+		const PhysicsKernels* table = kernelTable(*rules);
+		// 表中第 0 项即该规则集的标量参考积分 Ball::integrate<R>
+		const PhysicsKernels& scalar = table[0];
+		for (size_t n = 0; n < KERNEL_COUNT; ++n) {
+			const PhysicsKernels& k = table[n];
+			if (static_cast<int>(k.level) > static_cast<int>(detect())) continue;
+			BallStore ref, test;
+
+			makeSelfTestStore(ref, N, 777u, *rules);
+			makeSelfTestStore(test, N, 777u, *rules);
+			scalar.integrate(ref, 0, N, dt);
+			k.integrate(test, 0, N, dt);
+			bool okIntegrate = sameState(ref, test);
+
+			makeSelfTestStore(ref, N, 999u, *rules);
+			makeSelfTestStore(test, N, 999u, *rules);
+			for (size_t p = 0; p < pa.size(); p += 17) {
+				// 人为制造完全重合的球对
+				ref.x[pb[p]] = ref.x[pa[p]]; ref.y[pb[p]] = ref.y[pa[p]];
+				test.x[pb[p]] = test.x[pa[p]]; test.y[pb[p]] = test.y[pa[p]];
+			}
+			solveScalar(ref, pa.data(), pb.data(), pa.size());
+			k.solve(test, pa.data(), pb.data(), pa.size());
+			bool okSolve = sameState(ref, test);
+
+			out << "  " << rules->name << "/" << k.name << ": integrate " << (okIntegrate ? "ok" : "MISMATCH")
+				<< ", solve " << (okSolve ? "ok" : "MISMATCH") << "\n";
+			allOk = allOk && okIntegrate && okSolve;
+		}
+	}
+	return allOk;
+}
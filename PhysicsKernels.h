@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+
+struct BallStore;
+struct RuleSet;
+
+// 指令集级别（运行时检测 CPU 后选择可用的最高级别）
+enum class SimdLevel { Scalar = 0, SSE = 1, AVX2 = 2 };
+
+// 物理热循环内核表：积分与分离求解各有标量 / SSE（4 路）/ AVX2（8 路）实现。
+// 标量版本即参考实现（积分直接使用 Ball::integrate<R>），向量版本必须与之逐位一致（由 selfTest 校验）。
+// 积分内核按规则集实例化（物理常数为编译期常量），每个内置规则集各有一张内核表。
+struct PhysicsKernels {
+	// 对 [begin, end) 范围内的球做一次积分
+	using IntegrateFn = void (*)(BallStore& balls, size_t begin, size_t end, float dt);
+	// 按顺序求解 count 个球对 (a[k], b[k]) 的重叠分离；
+	// 向量版本要求同一次调用中的球对两两不共享球（由 World 的着色分批保证）
+	using SolveFn = void (*)(BallStore& balls, const int* a, const int* b, size_t count);
+
+	SimdLevel level;
+	const char* name;
+	IntegrateFn integrate;
+	SolveFn solve;
+
+	// 当前 CPU 支持的最高级别
+	static SimdLevel detect();
+	// 取指定级别、指定规则集的内核；不支持的级别退回到可用的最高级别（不带规则集时为原版规则）
+	static const PhysicsKernels& get(SimdLevel level);
+	static const PhysicsKernels& get(SimdLevel level, const RuleSet& rules);
+	// 取运行时自动选择的内核
+	static const PhysicsKernels& best();
+	static const PhysicsKernels& best(const RuleSet& rules);
+
+	// 对每个内置规则集，用随机数据对比每个可用向量内核与标量内核的结果，报告写入 out；全部一致返回 true
+	static bool selfTest(std::ostream& out);
+};
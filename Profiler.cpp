@@ -0,0 +1,159 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+const char* const PHASE_NAMES[Profiler::PHASE_COUNT] = {
+	"integrate", "support", "merge", "separation", "walls", "other", "render", "frame"
+};
+
+// 线程编号：每个线程第一次记录时分配
+std::uint8_t threadIndex()
+{
+	static std::atomic<unsigned> nextThread{0};
+	thread_local std::uint8_t index = static_cast<std::uint8_t>(nextThread.fetch_add(1));
+	return index;
+}
+
+} // namespace
+
+Profiler::Profiler(size_t capacity)
+{
+	size_t n = 1;
+	while (n < capacity) n <<= 1;
+	slots.reset(new Slot[n]);
+	mask = n - 1;
+	frameMs.resize(PHASE_COUNT * MAX_STAT_FRAMES);
+	sorted.reserve(MAX_STAT_FRAMES);
+}
+
+std::uint64_t Profiler::now()
+{
+	return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+const char* Profiler::phaseName(Phase phase)
+{
+	return phase < PHASE_COUNT ? PHASE_NAMES[phase] : "?";
+}
+
+void Profiler::record(Phase phase, std::uint64_t begin, std::uint64_t end)
+{
+	std::uint64_t ticket = head.fetch_add(1, std::memory_order_relaxed);
+	Slot& s = slots[ticket & mask];
+	s.seq.store(2 * ticket + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s.begin.store(begin, std::memory_order_relaxed);
+	s.end.store(end, std::memory_order_relaxed);
+	s.meta.store(static_cast<std::uint64_t>(getFrame()) << 16 | static_cast<std::uint64_t>(phase) << 8 | threadIndex(),
+	             std::memory_order_relaxed);
+	s.seq.store(2 * ticket + 2, std::memory_order_release);
+}
+
+bool Profiler::read(std::uint64_t ticket, Event& ev) const
+{
+	const Slot& s = slots[ticket & mask];
+	if (s.seq.load(std::memory_order_acquire) != 2 * ticket + 2) return false;
+	ev.begin = s.begin.load(std::memory_order_relaxed);
+	ev.end = s.end.load(std::memory_order_relaxed);
+	std::uint64_t meta = s.meta.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (s.seq.load(std::memory_order_relaxed) != 2 * ticket + 2) return false;
+	ev.frame = static_cast<std::uint32_t>(meta >> 16);
+	ev.phase = static_cast<Phase>((meta >> 8) & 0xff);
+	ev.thread = static_cast<std::uint8_t>(meta & 0xff);
+	return true;
+}
+
+void Profiler::clear()
+{
+	startFrame.store(getFrame(), std::memory_order_relaxed);
+	startTicket.store(head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+void Profiler::collect(std::vector<Event>& out) const
+{
+	out.clear();
+	const std::uint64_t start = startTicket.load(std::memory_order_acquire);
+	std::uint64_t last = head.load(std::memory_order_acquire);
+	std::uint64_t first = std::max(start, last > mask ? last - mask - 1 : 0);
+	for (std::uint64_t t = first; t < last; ++t) {
+		Event ev;
+		if (read(t, ev)) out.push_back(ev);
+	}
+}
+
+void Profiler::summarize(size_t frames, Stats out[PHASE_COUNT])
+{
+	frames = std::min(frames, MAX_STAT_FRAMES);
+	const std::uint32_t current = getFrame();
+	frames = std::min<size_t>(frames, current - startFrame.load(std::memory_order_relaxed));
+	std::fill(frameMs.begin(), frameMs.end(), 0.0);
+	for (size_t p = 0; p < PHASE_COUNT; ++p) out[p] = Stats();
+	if (frames == 0) return;
+
+	// 从最新的事件往回扫，直到超出统计窗口的帧
+	const std::uint32_t oldest = current - static_cast<std::uint32_t>(frames);
+	const std::uint64_t start = startTicket.load(std::memory_order_acquire);
+	std::uint64_t last = head.load(std::memory_order_acquire);
+	std::uint64_t first = std::max(start, last > mask ? last - mask - 1 : 0);
+	for (std::uint64_t t = last; t > first; --t) {
+		Event ev;
+		if (!read(t - 1, ev)) continue;
+		if (ev.frame < oldest) break;
+		if (ev.frame >= current || ev.phase >= PHASE_COUNT) continue;
+		frameMs[ev.phase * MAX_STAT_FRAMES + (ev.frame - oldest)] += (ev.end - ev.begin) * 1e-6;
+	}
+
+	for (size_t p = 0; p < PHASE_COUNT; ++p) {
+		const double* ms = &frameMs[p * MAX_STAT_FRAMES];
+		sorted.assign(ms, ms + frames);
+		std::sort(sorted.begin(), sorted.end());
+		double sum = 0.0;
+		for (double v : sorted) sum += v;
+		out[p].mean = sum / frames;
+		out[p].p50 = sorted[(frames - 1) / 2];
+		out[p].p95 = sorted[(frames - 1) * 95 / 100];
+		out[p].max = sorted.back();
+	}
+}
+
+bool Profiler::writeCsv(const std::string& path) const
+{
+	std::vector<Event> events;
+	collect(events);
+	std::ofstream out(path);
+	if (!out) return false;
+	out << "frame,thread,phase,begin_ns,duration_ns\n";
+	const std::uint64_t base = events.empty() ? 0 : events.front().begin;
+	for (const Event& e : events)
+		out << e.frame << "," << int(e.thread) << "," << phaseName(e.phase) << ","
+			<< (e.begin - base) << "," << (e.end - e.begin) << "\n";
+	return static_cast<bool>(out);
+}
+
+// Chrome trace 的 JSON 对象格式：每个事件一个完整事件（ph = "X"），时间单位为微秒
+bool Profiler::writeChromeTrace(const std::string& path) const
+{
+	std::vector<Event> events;
+	collect(events);
+	std::ofstream out(path);
+	if (!out) return false;
+	out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+	const std::uint64_t base = events.empty() ? 0 : events.front().begin;
+	char buf[256];
+	for (size_t i = 0; i < events.size(); ++i) {
+		const Event& e = events[i];
+		std::snprintf(buf, sizeof(buf),
+			"  {\"name\": \"%s\", \"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %u}}%s\n",
+			phaseName(e.phase), int(e.thread), (e.begin - base) * 1e-3, (e.end - e.begin) * 1e-3,
+			static_cast<unsigned>(e.frame), i + 1 < events.size() ? "," : "");
+		out << buf;
+	}
+	out << "]}\n";
+	return static_cast<bool>(out);
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 分阶段帧剖析器：各阶段的 [开始, 结束) 时间写入固定容量的无锁环形缓冲（任意线程可写，满了覆盖最旧的），
+// 供界面统计最近若干帧的每阶段耗时分位数，或导出为 CSV / Chrome trace（chrome://tracing、Perfetto）。
+// 模拟只持有一个 Profiler 指针，未挂接时不读时钟也不写缓冲，开销只有一次指针判断。
+class Profiler {
+public:
+	enum Phase : std::uint8_t {
+		Integrate,   // 积分
+		Support,     // 宽相 + 接触表 + 支撑图
+		Merge,       // 合并判定与生成合成球
+		Separation,  // 候选球对着色 + 多遍分离
+		Walls,       // 左右墙约束
+		Other,       // 休眠、生命线、轮廓与清理
+		Render,      // 顶点构建与绘制
+		Frame,       // 整帧
+		PHASE_COUNT
+	};
+
+	struct Event {
+		std::uint64_t begin;  // 纳秒（steady_clock）
+		std::uint64_t end;
+		std::uint32_t frame;
+		Phase phase;
+		std::uint8_t thread;  // 记录线程的编号（按首次记录的先后分配）
+	};
+
+	// 一个阶段在最近若干帧内的每帧耗时统计（毫秒）
+	struct Stats {
+		double mean = 0.0;
+		double p50 = 0.0;
+		double p95 = 0.0;
+		double max = 0.0;
+	};
+
+	// capacity 向上取整为 2 的幂
+	explicit Profiler(size_t capacity = 1 << 16);
+
+	static std::uint64_t now();
+	static const char* phaseName(Phase phase);
+
+	void record(Phase phase, std::uint64_t begin, std::uint64_t end);
+	// 开始新的一帧：之后记录的事件归入新帧号
+	void nextFrame() { frame.fetch_add(1, std::memory_order_relaxed); }
+	std::uint32_t getFrame() const { return frame.load(std::memory_order_relaxed); }
+	// 丢弃已记录的事件：只移动有效区间的起点，不改写槽位，可以与其他线程的 record 并发调用
+	// （正在写入的事件可能被丢弃，但不会破坏缓冲）
+	void clear();
+
+	// 按时间顺序取出缓冲中仍然完整的事件（写到一半的槽位被跳过）
+	void collect(std::vector<Event>& out) const;
+	// 统计当前帧之前最近 frames 帧（不超过 MAX_STAT_FRAMES）各阶段的每帧耗时；
+	// 使用内部预留的缓冲，不分配内存，只应在一个线程上调用
+	void summarize(size_t frames, Stats out[PHASE_COUNT]);
+	static constexpr size_t MAX_STAT_FRAMES = 600;
+
+	bool writeCsv(const std::string& path) const;
+	bool writeChromeTrace(const std::string& path) const;
+
+private:
+	// 每个槽位用序号做版本（写入中为奇数，完成后为偶数），读者据此丢弃被并发覆盖的槽位
+	struct Slot {
+		std::atomic<std::uint64_t> seq{0};
+		std::atomic<std::uint64_t> begin{0};
+		std::atomic<std::uint64_t> end{0};
+		std::atomic<std::uint64_t> meta{0};  // frame << 16 | phase << 8 | thread
+	};
+	bool read(std::uint64_t ticket, Event& ev) const;
+
+	std::unique_ptr<Slot[]> slots;
+	size_t mask = 0;
+	std::atomic<std::uint64_t> head{0};
+	std::atomic<std::uint32_t> frame{0};
+	// clear 时的 head 与帧号：更早的序号与帧不再读取
+	std::atomic<std::uint64_t> startTicket{0};
+	std::atomic<std::uint32_t> startFrame{0};
+
+	// summarize 的预留缓冲
+	std::vector<double> frameMs;  // [phase * MAX_STAT_FRAMES + frame]
+	std::vector<double> sorted;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+// 每局独立的快速伪随机数（PCG32，XSH-RR 输出）：只依赖种子与调用顺序，
+// 同一种子在任何平台上产生相同序列，替代全局的 std::rand 以便复现整局游戏。
+class Rng {
+public:
+	explicit Rng(std::uint64_t seed = 1) { reseed(seed); }
+
+	void reseed(std::uint64_t seed)
+	{
+		state = 0;
+		next();
+		state += seed;
+		next();
+	}
+
+	std::uint32_t next()
+	{
+		std::uint64_t old = state;
+		state = old * 6364136223846793005ull + INCREMENT;
+		std::uint32_t xorshifted = static_cast<std::uint32_t>(((old >> 18u) ^ old) >> 27u);
+		std::uint32_t rot = static_cast<std::uint32_t>(old >> 59u);
+		return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+	}
+
+	// [0, n) 内的整数（乘法映射，n 很小时偏差可忽略）
+	int below(int n)
+	{
+		return static_cast<int>((static_cast<std::uint64_t>(next()) * static_cast<std::uint32_t>(n)) >> 32);
+	}
+
+	std::uint64_t getState() const { return state; }
+	void setState(std::uint64_t s) { state = s; }
+
+private:
+	static constexpr std::uint64_t INCREMENT = 1442695040888963407ull;
+	std::uint64_t state = 0;
+};
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 一套完整的游戏规则：容器尺寸、物理常数、等级数与分数规则，以及由它们在编译期生成的逐级查表
+// （半径、质量、合成得分、颜色）。规则集都是 constexpr 常量，积分内核以规则集为模板参数实例化，
+// 热循环中的重力、地面与反弹系数都是编译期常量，不需要运行时分支或查表。
+//
+// 新增规则集：在 Rules 命名空间中用 makeRuleSet 定义常量，并加入下面的 SBS_RULE_SETS 列表
+// （内核显式实例化与按名称查找都由该列表生成）。
+struct RuleSet {
+	// 查表容量（等级 0..MAX_LEVELS-1）
+	static constexpr int MAX_LEVELS = 16;
+
+	std::uint32_t id = 0;   // 写入记录与快照，用于校验规则一致
+	const char* name = "";
+	int maxLevel = 10;      // 最高等级，合成到该等级视为胜利
+	float width = 480.f;    // 容器宽度（像素）
+	float floorY = 800.f;   // 地面 y，同时是容器高度
+	float lifelineY = 240.f;
+	float gravity = 980.f;
+	float restitution = 0.15f; // 反弹系数（0..1），越小损失越大
+	float friction = 4.f;      // 地面摩擦减速度（每秒）
+	size_t maxBalls = 200;
+	int level3UnlockScore = 1000; // 解锁第 3 级预览所需分数
+
+	// 编译期生成的逐级查表
+	float radius[MAX_LEVELS] = {};
+	float mass[MAX_LEVELS] = {};
+	int mergeScore[MAX_LEVELS] = {};     // 合成出该等级时的得分
+	std::uint32_t color[MAX_LEVELS] = {}; // 0xRRGGBB，贴图缺失时的纯色
+};
+
+// 规则集的可调参数；半径按 baseRadius + level * radiusStep 线性增长
+struct RuleParams {
+	std::uint32_t id;
+	const char* name;
+	int maxLevel;
+	float width, floorY, lifelineY;
+	float gravity, restitution, friction;
+	size_t maxBalls;
+	int level3UnlockScore;
+	float baseRadius, radiusStep;
+	int scorePerLevel;
+};
+
+namespace Rules {
+
+// 原版调色板（第 1-3 级为明确可区分的颜色）；更高等级按黄金角旋转色相生成
+constexpr std::uint32_t PALETTE[12] = {
+	0xB4B4B4, 0xDC5050, 0x50B45A, 0x4682E6, 0xE6BE3C, 0xBE5AB4,
+	0x5ABEC8, 0xC8783C, 0x9696DC, 0xDC7878, 0x78DCB4, 0xC8C8C8
+};
+
+constexpr std::uint32_t levelColor(int level)
+{
+	if (level < 12) return PALETTE[level];
+	// 饱和度与亮度固定的 HSV 色相环，六段线性插值
+	const int hue = (level * 137) % 360;
+	const int hi = 220, lo = 80;
+	const int t = lo + (hi - lo) * (hue % 60) / 60;
+	int r = hi, g = lo, b = lo;
+	switch (hue / 60) {
+	case 0: g = t; break;
+	case 1: r = hi + lo - t; g = hi; break;
+	case 2: r = lo; g = hi; b = t; break;
+	case 3: r = lo; g = hi + lo - t; b = hi; break;
+	case 4: r = t; g = lo; b = hi; break;
+	default: b = hi + lo - t; break;
+	}
+	return static_cast<std::uint32_t>((r << 16) | (g << 8) | b);
+}
+
+// 质量与面积相关（近似）：质量与半径的平方成正比
+constexpr float massByRadius(float r)
+{
+	return r * r * 0.001f > 0.1f ? r * r * 0.001f : 0.1f;
+}
+
+constexpr RuleSet makeRuleSet(const RuleParams& p)
+{
+	RuleSet s;
+	s.id = p.id;
+	s.name = p.name;
+	s.maxLevel = p.maxLevel < RuleSet::MAX_LEVELS - 1 ? p.maxLevel : RuleSet::MAX_LEVELS - 1;
+	s.width = p.width;
+	s.floorY = p.floorY;
+	s.lifelineY = p.lifelineY;
+	s.gravity = p.gravity;
+	s.restitution = p.restitution;
+	s.friction = p.friction;
+	s.maxBalls = p.maxBalls;
+	s.level3UnlockScore = p.level3UnlockScore;
+	for (int l = 0; l < RuleSet::MAX_LEVELS; ++l) {
+		s.radius[l] = p.baseRadius + l * p.radiusStep;
+		s.mass[l] = massByRadius(s.radius[l]);
+		s.mergeScore[l] = l * p.scorePerLevel;
+		s.color[l] = levelColor(l);
+	}
+	return s;
+}
+
+// 原版规则：480x800，10 级
+inline constexpr RuleSet CLASSIC = makeRuleSet({
+	0, "classic", 10, 480.f, 800.f, 240.f, 980.f, 0.15f, 4.f, 200, 1000, 18.f, 8.f, 50 });
+// 宽盘：720 宽，12 级，每级增幅略小，球数上限更高
+inline constexpr RuleSet WIDE = makeRuleSet({
+	1, "wide", 12, 720.f, 800.f, 240.f, 980.f, 0.15f, 4.f, 320, 1000, 18.f, 7.f, 50 });
+// 深井：480x960，13 级小球，重力更大、反弹更小
+inline constexpr RuleSet DEEP = makeRuleSet({
+	2, "deep", 13, 480.f, 960.f, 260.f, 1100.f, 0.1f, 4.f, 260, 1500, 14.f, 6.f, 60 });
+
+// 全部内置规则集（X 宏）：用于显式实例化各规则集的内核
+#define SBS_RULE_SETS(X) X(CLASSIC) X(WIDE) X(DEEP)
+
+inline constexpr const RuleSet* ALL[] = { &CLASSIC, &WIDE, &DEEP };
+
+inline const RuleSet* findById(std::uint32_t id)
+{
+	for (const RuleSet* r : ALL)
+		if (r->id == id) return r;
+	return nullptr;
+}
+
+inline const RuleSet* findByName(const char* name)
+{
+	for (const RuleSet* r : ALL)
+		if (std::strcmp(r->name, name) == 0) return r;
+	return nullptr;
+}
+
+} // namespace Rules
@@ -0,0 +1,196 @@
+#include "SessionHost.h"
+#include "Profiler.h"
+#include <algorithm>
+
+SessionHost::SessionHost()
+	: SessionHost(Config())
+{
+}
+
+SessionHost::SessionHost(const Config& cfg)
+	: config(cfg), pool(cfg.threads)
+{
+	if (config.stepsPerRound < 1) config.stepsPerRound = 1;
+	if (config.maxLagRounds < 1) config.maxLagRounds = 1;
+}
+
+SessionHost::Session& SessionHost::add(std::unique_ptr<Session> s)
+{
+	s->latency.assign(LATENCY_SAMPLES, 0);
+	sessions.push_back(std::move(s));
+	order.reserve(sessions.size());
+	return *sessions.back();
+}
+
+size_t SessionHost::addReplay(const SessionLog& log)
+{
+	std::unique_ptr<Session> s(new Session());
+	s->driver = Driver::Replay;
+	s->log.reset(new SessionLog(log));
+	// 与 SessionLog::replay 相同：World 的全部设置（含旧版本记录的默认值）都由 createWorld 决定
+	s->world = log.createWorld();
+	s->stepSeconds = log.getStepSeconds();
+	if (!s->world) {
+		s->finished = true;
+		s->ok = false;
+		s->message = "unknown rule set";
+	}
+	add(std::move(s));
+	return sessions.size() - 1;
+}
+
+size_t SessionHost::addRandom(const RuleSet& rules, std::uint64_t seed, int dropInterval, std::uint64_t maxSteps)
+{
+	std::unique_ptr<Session> s(new Session());
+	s->driver = Driver::Random;
+	s->world.reset(new World(rules));
+	s->world->setSeed(seed);
+	s->rng.reseed(seed ^ 0x9e3779b97f4a7c15ull);
+	s->dropInterval = dropInterval < 1 ? 1 : dropInterval;
+	s->stepSeconds = config.stepSeconds;
+	s->maxSteps = maxSteps;
+	add(std::move(s));
+	return sessions.size() - 1;
+}
+
+size_t SessionHost::addBot(const RuleSet& rules, std::uint64_t seed, const Bot::Config& cfg, std::uint64_t maxSteps)
+{
+	std::unique_ptr<Session> s(new Session());
+	s->driver = Driver::Bot;
+	s->world.reset(new World(rules));
+	s->world->setSeed(seed);
+	// 并行度来自同时运行的多个对局，每个 Bot 只在所属任务的线程上推演
+	Bot::Config botCfg = cfg;
+	botCfg.threads = 1;
+	botCfg.seed = seed;
+	s->bot.reset(new Bot(botCfg));
+	s->dropInterval = botCfg.settleSteps < 1 ? 1 : botCfg.settleSteps;
+	s->stepSeconds = Bot::STEP;
+	s->maxSteps = maxSteps;
+	add(std::move(s));
+	return sessions.size() - 1;
+}
+
+// 推进一个固定步：先由驱动注入本步之前的输入，再执行 World::step 并记录耗时
+void SessionHost::stepOnce(Session& s)
+{
+	World& world = *s.world;
+	if (s.driver == Driver::Replay) {
+		const SessionLog& log = *s.log;
+		if (s.steps >= log.getFinalStep()) {
+			finishReplay(s);
+			return;
+		}
+		if (!log.applyEvents(world, s.steps, s.nextEvent, s.message)) {
+			s.finished = true;
+			s.ok = false;
+			return;
+		}
+	} else if (s.steps % static_cast<std::uint64_t>(s.dropInterval) == 0 && !world.isGameOver()) {
+		float x;
+		if (s.driver == Driver::Bot) {
+			x = s.bot->chooseDrop(world);
+		} else {
+			// 与 World::spawnBall 的横向限制一致：两侧各留 28 像素
+			const int span = std::max(1, static_cast<int>(world.getWidth()) - 56);
+			x = 28.f + static_cast<float>(s.rng.below(span));
+		}
+		world.dropNext(x, Bot::DROP_Y);
+	}
+
+	const std::uint64_t t0 = Profiler::now();
+	world.step(s.stepSeconds);
+	const std::uint64_t ns = Profiler::now() - t0;
+	s.latency[s.latencyCount++ % LATENCY_SAMPLES] = static_cast<std::uint32_t>(std::min<std::uint64_t>(ns, UINT32_MAX));
+	++s.steps;
+
+	if (s.driver == Driver::Replay) {
+		if (s.steps >= s.log->getFinalStep()) finishReplay(s);
+	} else if (world.isGameOver() || world.isGameWin() || (s.maxSteps && s.steps >= s.maxSteps)) {
+		s.finished = true;
+	}
+}
+
+// 重放到记录的结束步：校验事件全部用完且状态哈希一致
+void SessionHost::finishReplay(Session& s)
+{
+	const SessionLog& log = *s.log;
+	const World& world = *s.world;
+	s.finished = true;
+	s.ok = log.checkEnd(world, s.nextEvent, s.message);
+}
+
+// 用掉该局的额度；超出每轮的时间预算时把剩余额度留到下一轮
+void SessionHost::advance(Session& s)
+{
+	const std::uint64_t t0 = Profiler::now();
+	std::uint64_t t = t0;
+	while (s.credit > 0 && !s.finished) {
+		stepOnce(s);
+		--s.credit;
+		t = Profiler::now();
+		if (config.roundBudgetNs && t - t0 >= config.roundBudgetNs) break;
+	}
+	s.busyNs += t - t0;
+	if (s.finished) s.credit = 0;
+}
+
+bool SessionHost::round()
+{
+	const std::uint64_t t0 = Profiler::now();
+	const int maxCredit = config.stepsPerRound * config.maxLagRounds;
+	order.clear();
+	for (auto& s : sessions) {
+		if (s->finished) continue;
+		s->credit = std::min(s->credit + config.stepsPerRound, maxCredit);
+		order.push_back(s.get());
+	}
+	if (order.empty()) return false;
+
+	// 欠步多的对局先调度；额度相同时按轮次轮换起点，避免总是同一批对局排在最后
+	const size_t n = order.size();
+	const size_t rotate = static_cast<size_t>(rounds % n);
+	for (size_t k = 0; k < n; ++k) order[k]->slot = (k + n - rotate) % n;
+	std::sort(order.begin(), order.end(), [](const Session* a, const Session* b) {
+		return a->credit != b->credit ? a->credit > b->credit : a->slot < b->slot;
+	});
+
+	pool.run(n, [&](size_t k, unsigned) { advance(*order[k]); });
+	++rounds;
+	wallNs += Profiler::now() - t0;
+	return true;
+}
+
+void SessionHost::runToCompletion(std::uint64_t maxRounds)
+{
+	for (std::uint64_t r = 0; (maxRounds == 0 || r < maxRounds) && round(); ++r) {
+	}
+}
+
+SessionHost::Report SessionHost::report() const
+{
+	Report rep;
+	rep.sessions = sessions.size();
+	rep.rounds = rounds;
+	rep.seconds = static_cast<double>(wallNs) * 1e-9;
+	rep.steals = pool.getSteals();
+	std::vector<std::uint32_t> samples;
+	for (const auto& s : sessions) {
+		if (s->finished) ++rep.finished;
+		rep.steps += s->steps;
+		const size_t n = static_cast<size_t>(std::min<std::uint64_t>(s->latencyCount, LATENCY_SAMPLES));
+		samples.insert(samples.end(), s->latency.begin(), s->latency.begin() + static_cast<std::ptrdiff_t>(n));
+	}
+	if (rep.seconds > 0.0) rep.stepsPerSecond = static_cast<double>(rep.steps) / rep.seconds;
+	if (!samples.empty()) {
+		auto pick = [&](double q) {
+			size_t k = std::min(samples.size() - 1, static_cast<size_t>(q * static_cast<double>(samples.size())));
+			std::nth_element(samples.begin(), samples.begin() + static_cast<std::ptrdiff_t>(k), samples.end());
+			return static_cast<double>(samples[k]);
+		};
+		rep.p50Ns = pick(0.50);
+		rep.p99Ns = pick(0.99);
+		rep.maxNs = static_cast<double>(*std::max_element(samples.begin(), samples.end()));
+	}
+	return rep;
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "World.h"
+#include "Bot.h"
+#include "Rng.h"
+#include "SessionLog.h"
+#include "WorkStealingPool.h"
+
+// 在一个进程内同时运行许多互相独立的无窗口对局（锦标赛、AI 对战、服务器端校验客户端分数）。
+// 每次 round 给每个未结束的对局追加 stepsPerRound 个固定步的额度，各对局作为一个任务交给窃取式线程池推进；
+// 单个对局在一轮内最多占用 roundBudgetNs 纳秒，用不完的额度留到下一轮（欠步最多的对局下一轮最先调度），
+// 因此重的对局不会拖住轻的对局，落后的对局会被优先追上。
+// 每局的输入只来自它自己的驱动（记录、随机投放或 AI），与调度顺序和线程数无关，结果逐位确定。
+class SessionHost {
+public:
+	struct Config {
+		unsigned threads = 0;               // 线程数（含调用线程，0 表示取硬件线程数）
+		float stepSeconds = 1.f / 60.f;     // 非重放对局的固定步长（重放对局使用记录中的步长）
+		int stepsPerRound = 1;              // 每轮追加给每个对局的步数额度
+		std::uint64_t roundBudgetNs = 0;    // 单个对局每轮最多占用的时间（0 表示不限，额度用完为止）
+		int maxLagRounds = 8;               // 欠下的额度最多累积多少轮（超出部分丢弃，避免追赶时长时间独占）
+	};
+
+	// 对局的输入来源
+	enum class Driver : std::uint8_t {
+		Replay, // 按 SessionLog 重放并在结束时校验状态哈希（服务器端校验）
+		Random, // 每 dropInterval 步在随机横坐标投放一次
+		Bot     // 每 settleSteps 步由单线程 Bot 选择投放位置
+	};
+
+	struct Session {
+		Driver driver = Driver::Random;
+		std::unique_ptr<World> world;
+		std::unique_ptr<SessionLog> log;    // Replay
+		std::unique_ptr<Bot> bot;           // Bot
+		Rng rng;                            // Random 的投放位置
+		int dropInterval = 60;
+		float stepSeconds = 1.f / 60.f;
+		std::uint64_t maxSteps = 0;         // 非重放对局的步数上限
+		std::uint64_t steps = 0;            // 已推进的固定步数
+		size_t nextEvent = 0;
+		int credit = 0;                     // 尚未使用的步数额度
+		size_t slot = 0;                    // 本轮轮换后的位置（额度相同时的调度次序）
+		bool finished = false;
+		bool ok = true;                     // Replay：事件与结束哈希都一致
+		std::string message;
+		std::uint64_t busyNs = 0;           // 推进该局的累计耗时（含驱动的决策）
+		std::vector<std::uint32_t> latency; // 最近 LATENCY_SAMPLES 个 World::step 的耗时（纳秒，环形）
+		std::uint64_t latencyCount = 0;
+	};
+
+	// 汇总：全部对局的步数吞吐与单步耗时分位数
+	struct Report {
+		size_t sessions = 0;
+		size_t finished = 0;
+		std::uint64_t rounds = 0;
+		std::uint64_t steps = 0;
+		double seconds = 0.0;        // round 的累计墙钟时间
+		double stepsPerSecond = 0.0;
+		double p50Ns = 0.0, p99Ns = 0.0, maxNs = 0.0;
+		std::uint64_t steals = 0;
+	};
+
+	static constexpr size_t LATENCY_SAMPLES = 1024;
+
+	SessionHost();
+	explicit SessionHost(const Config& cfg);
+
+	// 添加对局，返回其编号；log 的规则集未知时返回的对局直接以失败结束
+	size_t addReplay(const SessionLog& log);
+	size_t addRandom(const RuleSet& rules, std::uint64_t seed, int dropInterval, std::uint64_t maxSteps);
+	size_t addBot(const RuleSet& rules, std::uint64_t seed, const Bot::Config& cfg, std::uint64_t maxSteps);
+
+	// 推进一轮；返回 false 表示所有对局都已结束
+	bool round();
+	// 连续推进直到所有对局结束（或达到 maxRounds 轮，0 表示不限）
+	void runToCompletion(std::uint64_t maxRounds = 0);
+
+	size_t size() const { return sessions.size(); }
+	const Session& get(size_t i) const { return *sessions[i]; }
+	unsigned getThreads() const { return pool.size(); }
+	Report report() const;
+
+private:
+	Session& add(std::unique_ptr<Session> s);
+	void advance(Session& s);
+	void stepOnce(Session& s);
+	void finishReplay(Session& s);
+
+	Config config;
+	WorkStealingPool pool;
+	std::vector<std::unique_ptr<Session>> sessions;
+	std::vector<Session*> order;  // 本轮的调度顺序（欠步多的在前）
+	std::uint64_t rounds = 0;
+	std::uint64_t wallNs = 0;
+};
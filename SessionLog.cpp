@@ -0,0 +1,210 @@
+#include "SessionLog.h"
+#include "World.h"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+const char MAGIC[4] = {'S', 'B', 'R', 'P'};
+const std::uint32_t VERSION = 5;
+
+// 按本机字节序逐字段读写（目标平台均为小端）
+template <class T>
+void put(std::ostream& out, T v)
+{
+	out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template <class T>
+bool get(std::istream& in, T& v)
+{
+	return static_cast<bool>(in.read(reinterpret_cast<char*>(&v), sizeof(T)));
+}
+
+} // namespace
+
+void SessionLog::begin(const World& world, float step)
+{
+	rulesId = world.getRules().id;
+	seed = world.getSeed();
+	width = world.getWidth();
+	height = world.getHeight();
+	stepSeconds = step;
+	substeps = static_cast<std::uint32_t>(world.getSubsteps());
+	maxBalls = static_cast<std::uint32_t>(world.getMaxBalls());
+	separationPasses = static_cast<std::uint32_t>(world.getSeparationPasses());
+	continuousCollision = world.isContinuousCollisionEnabled() ? 1 : 0;
+	mergeCascades = world.isMergeCascadesEnabled() ? 1 : 0;
+	sleeping = world.isSleepingEnabled() ? 1 : 0;
+	baseStep = world.getStepCount();
+	events.clear();
+	finalStep = 0;
+	finalHash = 0;
+}
+
+void SessionLog::recordDrop(const World& world, float x, float y)
+{
+	std::uint32_t step = static_cast<std::uint32_t>(world.getStepCount() - baseStep);
+	events.push_back({step, EventType::Drop, static_cast<std::uint8_t>(world.getNextSpawnLevel()), x, y});
+}
+
+void SessionLog::recordReset(const World& world)
+{
+	std::uint32_t step = static_cast<std::uint32_t>(world.getStepCount() - baseStep);
+	events.push_back({step, EventType::Reset, 0, 0.f, 0.f});
+}
+
+void SessionLog::finish(const World& world)
+{
+	finalStep = world.getStepCount() - baseStep;
+	finalHash = world.stateHash();
+}
+
+bool SessionLog::save(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out) return false;
+	out.write(MAGIC, sizeof(MAGIC));
+	put(out, VERSION);
+	put(out, rulesId);
+	put(out, seed);
+	put(out, width);
+	put(out, height);
+	put(out, stepSeconds);
+	put(out, substeps);
+	put(out, maxBalls);
+	put(out, separationPasses);
+	put(out, continuousCollision);
+	put(out, mergeCascades);
+	put(out, sleeping);
+	put(out, static_cast<std::uint32_t>(events.size()));
+	for (const Event& e : events) {
+		put(out, e.step);
+		put(out, static_cast<std::uint8_t>(e.type));
+		put(out, e.level);
+		put(out, e.x);
+		put(out, e.y);
+	}
+	put(out, finalStep);
+	put(out, finalHash);
+	return static_cast<bool>(out);
+}
+
+bool SessionLog::load(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	char magic[4];
+	std::uint32_t version = 0, count = 0;
+	if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0) return false;
+	if (!get(in, version) || version < 1 || version > VERSION) return false;
+	rulesId = Rules::CLASSIC.id;
+	if (version >= 2 && !get(in, rulesId)) return false;
+	if (!get(in, seed) || !get(in, width) || !get(in, height) || !get(in, stepSeconds)
+		|| !get(in, substeps) || !get(in, maxBalls)) return false;
+	// 版本 3 起记录求解器设置；更早的记录使用当时固定的 4 次迭代、无连续碰撞
+	separationPasses = 4;
+	continuousCollision = 0;
+	if (version >= 3 && (!get(in, separationPasses) || !get(in, continuousCollision))) return false;
+	// 版本 4 起记录连锁合并开关；更早的记录没有连锁合并
+	mergeCascades = 0;
+	if (version >= 4 && !get(in, mergeCascades)) return false;
+	// 版本 5 起记录休眠开关；版本 2~4 录制时休眠总是开启；版本 1 按加入休眠之前的行为（关闭）读取
+	sleeping = version >= 2 ? 1 : 0;
+	if (version >= 5 && !get(in, sleeping)) return false;
+	if (!get(in, count)) return false;
+	events.clear();
+	events.reserve(count);
+	for (std::uint32_t i = 0; i < count; ++i) {
+		Event e;
+		std::uint8_t type = 0;
+		if (!get(in, e.step) || !get(in, type) || !get(in, e.level) || !get(in, e.x) || !get(in, e.y)) return false;
+		if (type > static_cast<std::uint8_t>(EventType::Reset)) return false;
+		e.type = static_cast<EventType>(type);
+		events.push_back(e);
+	}
+	baseStep = 0;
+	return get(in, finalStep) && get(in, finalHash);
+}
+
+std::unique_ptr<World> SessionLog::createWorld(unsigned threads) const
+{
+	const RuleSet* rules = getRules();
+	if (!rules) return nullptr;
+	std::unique_ptr<World> world(new World(*rules, width, height, maxBalls));
+	world->setSubsteps(static_cast<int>(substeps));
+	world->setSeparationPasses(static_cast<int>(separationPasses));
+	world->setContinuousCollision(continuousCollision != 0);
+	world->setMergeCascades(mergeCascades != 0);
+	world->setSleeping(sleeping != 0);
+	world->setThreads(threads);
+	world->setSeed(seed);
+	return world;
+}
+
+bool SessionLog::applyEvents(World& world, std::uint64_t step, size_t& next, std::string& error) const
+{
+	for (; next < events.size() && events[next].step == step; ++next) {
+		const Event& e = events[next];
+		if (e.type == EventType::Reset) {
+			world.reset();
+			continue;
+		}
+		if (world.getNextSpawnLevel() != e.level) {
+			std::ostringstream oss;
+			oss << "diverged at step " << step << ": expected level " << int(e.level)
+				<< ", replay would spawn " << world.getNextSpawnLevel();
+			error = oss.str();
+			return false;
+		}
+		world.dropNext(e.x, e.y);
+	}
+	return true;
+}
+
+bool SessionLog::checkEnd(const World& world, size_t next, std::string& error) const
+{
+	if (next != events.size()) {
+		error = "events recorded after the final step";
+		return false;
+	}
+	const std::uint64_t hash = world.stateHash();
+	if (hash != finalHash) {
+		std::ostringstream oss;
+		oss << "final state hash mismatch: recorded " << std::hex << finalHash << ", replayed " << hash;
+		error = oss.str();
+		return false;
+	}
+	return true;
+}
+
+SessionLog::ReplayResult SessionLog::replay(unsigned threads) const
+{
+	ReplayResult result;
+	std::unique_ptr<World> created = createWorld(threads);
+	if (!created) {
+		result.message = "unknown rule set " + std::to_string(rulesId);
+		return result;
+	}
+	World& world = *created;
+
+	auto t0 = std::chrono::steady_clock::now();
+	size_t next = 0;
+	for (std::uint64_t step = 0; step < finalStep; ++step) {
+		if (!applyEvents(world, step, next, result.message)) {
+			result.steps = step;
+			result.hash = world.stateHash();
+			return result;
+		}
+		world.step(stepSeconds);
+	}
+	result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	result.steps = finalStep;
+	result.hash = world.stateHash();
+
+	result.ok = checkEnd(world, next, result.message);
+	return result;
+}
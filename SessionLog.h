@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Rules.h"
+
+class World;
+
+// 一局游戏的输入记录：随机种子 + 按固定步编号排序的玩家输入。
+// 模拟是确定性的，因此只需记录输入即可在无窗口环境下以最高速度重放整局，
+// 并用结束时的状态哈希确认重放结果与原局一致。
+//
+// 二进制格式（小端，按字段依次写入）：
+//   "SBRP" | u32 版本 | u32 规则集编号 | u64 种子 | f32 宽 | f32 高 | f32 步长 | u32 子步数 | u32 球数上限
+//   | u32 分离迭代次数 | u32 连续碰撞开关 | u32 连锁合并开关 | u32 休眠开关
+//   | u32 事件数 | 事件 * N（u32 步号, u8 类型, u8 等级, f32 x, f32 y） | u64 结束步号 | u64 结束哈希
+// 版本 1 没有规则集编号，按原版规则读取；版本 1、2 没有求解器设置，按 4 次迭代、无连续碰撞读取；
+// 版本 1~3 没有连锁合并开关，按关闭读取；版本 1~4 没有休眠开关，版本 1 按关闭、版本 2~4 按开启读取。
+class SessionLog {
+public:
+	enum class EventType : std::uint8_t { Drop = 0, Reset = 1 };
+
+	struct Event {
+		std::uint32_t step;  // 在记录开始后的第 step 个固定步之前生效
+		EventType type;
+		std::uint8_t level;  // Drop：实际生成的等级（回放时用于提前发现分歧）
+		float x, y;
+	};
+
+	struct ReplayResult {
+		bool ok = false;              // 全部事件一致且结束哈希匹配
+		std::uint64_t steps = 0;      // 重放的固定步数
+		std::uint64_t hash = 0;       // 重放结束时的状态哈希
+		double seconds = 0.0;         // 重放耗时（墙钟）
+		std::string message;          // 失败原因
+	};
+
+	// 开始记录：保存 World 的配置与种子（World 应处于刚设定种子、尚无球的初始状态）
+	void begin(const World& world, float stepSeconds);
+	// 记录一次投放（在调用 World::dropNext 之前调用）与一次重开
+	void recordDrop(const World& world, float x, float y);
+	void recordReset(const World& world);
+	// 记录结束状态（结束步号与哈希）
+	void finish(const World& world);
+
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	// 在新建的 World 上按记录重放，threads 为碰撞阶段线程数（不影响结果）
+	ReplayResult replay(unsigned threads = 1) const;
+
+	// 逐步重放的构件（replay 与 SessionHost 共用）：
+	// 按记录的规则集、尺寸、求解器设置、休眠开关与种子新建 World（旧版本记录缺少的设置已在 load 时确定）；
+	// 规则集未知时返回空指针
+	std::unique_ptr<World> createWorld(unsigned threads = 1) const;
+	// 在第 step 个固定步之前应用所有属于该步的事件，next 为下一个待应用事件的下标；
+	// 预览等级与记录不一致（重放已分歧）时返回 false 并写入 error
+	bool applyEvents(World& world, std::uint64_t step, size_t& next, std::string& error) const;
+	// 重放到结束步之后的校验：事件全部用完且状态哈希与记录一致时返回 true，否则写入 error
+	bool checkEnd(const World& world, size_t next, std::string& error) const;
+
+	const std::vector<Event>& getEvents() const { return events; }
+	std::uint64_t getSeed() const { return seed; }
+	// 记录时使用的规则集（未知编号时为 nullptr，无法重放）
+	const RuleSet* getRules() const { return Rules::findById(rulesId); }
+	std::uint64_t getFinalStep() const { return finalStep; }
+	std::uint64_t getFinalHash() const { return finalHash; }
+	float getStepSeconds() const { return stepSeconds; }
+
+private:
+	std::uint32_t rulesId = 0;
+	std::uint64_t seed = 1;
+	float width = 480.f;
+	float height = 0.f;
+	float stepSeconds = 1.f / 60.f;
+	std::uint32_t substeps = 1;
+	std::uint32_t maxBalls = 200;
+	std::uint32_t separationPasses = 4;
+	std::uint32_t continuousCollision = 0;
+	std::uint32_t mergeCascades = 0;
+	std::uint32_t sleeping = 1;
+	std::uint64_t baseStep = 0; // 开始记录时 World 的步数（事件步号相对于它）
+	std::vector<Event> events;
+	std::uint64_t finalStep = 0;
+	std::uint64_t finalHash = 0;
+};
@@ -0,0 +1,132 @@
+#include "SimulationThread.h"
+#include "AllocCounter.h"
+#include "Profiler.h"
+#include <cassert>
+#include <chrono>
+
+void SimFrame::reserve(size_t n)
+{
+	x.reserve(n);
+	y.reserve(n);
+	level.reserve(n);
+	handle.reserve(n);
+}
+
+void SimFrame::capture(const World& world)
+{
+	const BallStore& b = world.getBalls();
+	const size_t n = b.size();
+	x.assign(b.x.begin(), b.x.end());
+	y.assign(b.y.begin(), b.y.end());
+	level.assign(b.level.begin(), b.level.end());
+	handle.resize(n);
+	for (size_t i = 0; i < n; ++i) handle[i] = b.handle(i);
+	score = world.getScore();
+	nextSpawnLevel = world.getNextSpawnLevel();
+	gameOver = world.isGameOver();
+	gameWin = world.isGameWin();
+	lifelineY = world.getLifelineY();
+	dangerHeight = world.getDangerHeight();
+	step = world.getStepCount();
+}
+
+SimulationThread::SimulationThread(World& w, float stepSeconds, int maxCatchUpSteps)
+	: world(w), timestep(stepSeconds, maxCatchUpSteps)
+{
+	for (int i = 0; i < 3; ++i) buffer.slot(i).reserve(world.getMaxBalls());
+	pending.reserve(INPUT_CAPACITY);
+	working.reserve(INPUT_CAPACITY);
+}
+
+SimulationThread::~SimulationThread()
+{
+	stop();
+}
+
+void SimulationThread::start()
+{
+	if (thread.joinable()) return;
+	stopping.store(false);
+	timestep.reset();
+	// 先发布一帧，渲染线程在第一个固定步之前就有内容可画
+	publish();
+	thread = std::thread(&SimulationThread::loop, this);
+}
+
+void SimulationThread::stop()
+{
+	if (!thread.joinable()) return;
+	{
+		std::lock_guard<std::mutex> lock(inputMutex);
+		stopping.store(true);
+	}
+	inputReady.notify_one();
+	thread.join();
+}
+
+void SimulationThread::post(const Input& in)
+{
+	{
+		std::lock_guard<std::mutex> lock(inputMutex);
+		pending.push_back(in);
+		hasInput.store(true, std::memory_order_relaxed);
+	}
+	inputReady.notify_one();
+}
+
+void SimulationThread::publish()
+{
+	SimFrame& f = buffer.writeBuffer();
+	f.capture(world);
+	f.publishNs = Profiler::now();
+	buffer.publish();
+}
+
+void SimulationThread::loop()
+{
+	using Clock = std::chrono::steady_clock;
+	Clock::time_point last = Clock::now();
+	// 调试构建：稳定的一轮（无输入、球数与分数都不变）内，物理线程的推进与发布不得有堆分配
+	size_t lastBallCount = world.getBalls().size();
+	int lastScore = world.getScore();
+	for (;;) {
+		std::uint64_t allocs = AllocCounter::threadCount();
+		bool input = false;
+		{
+			std::unique_lock<std::mutex> lock(inputMutex);
+			if (stopping.load()) return;
+			if (hasInput.load(std::memory_order_relaxed)) {
+				pending.swap(working);
+				hasInput.store(false, std::memory_order_relaxed);
+				input = true;
+			}
+		}
+		// 输入在下一个固定步之前生效（与单线程主循环中先处理事件再推进的顺序相同）
+		for (const Input& in : working)
+			if (handler) handler(world, in);
+		working.clear();
+
+		Clock::time_point now = Clock::now();
+		int n = timestep.advance(std::chrono::duration<float>(now - last).count());
+		last = now;
+		for (int i = 0; i < n; ++i)
+			world.step(timestep.getStep());
+		if (n > 0 || input) {
+			steps.fetch_add(static_cast<std::uint64_t>(n), std::memory_order_relaxed);
+			publish();
+		}
+
+		size_t ballCount = world.getBalls().size();
+		bool steady = !input && ballCount == lastBallCount && world.getScore() == lastScore;
+		assert((!steady || AllocCounter::threadCount() == allocs) && "heap allocation in a steady-state simulation step");
+		(void)steady;
+		(void)allocs;
+		lastBallCount = ballCount;
+		lastScore = world.getScore();
+
+		// 等到下一个固定步到期；有新输入或要求停止时提前醒来
+		std::chrono::duration<float> wait(timestep.getStep() * (1.f - timestep.alpha()));
+		std::unique_lock<std::mutex> lock(inputMutex);
+		inputReady.wait_for(lock, wait, [this] { return stopping.load() || hasInput.load(std::memory_order_relaxed); });
+	}
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "World.h"
+#include "FixedTimestep.h"
+#include "TripleBuffer.h"
+
+// 物理线程每个固定步之后发布的只读画面状态：渲染所需的球位置与等级，以及界面显示的规则状态。
+// 各数组按球数上限预留容量，发布与复制都不分配内存
+struct SimFrame {
+	std::vector<float> x, y;
+	std::vector<std::uint8_t> level;
+	std::vector<BallStore::Handle> handle; // 用于在相邻两帧之间对应同一个球（合并掉的球没有对应）
+	int score = 0;
+	int nextSpawnLevel = 1;
+	bool gameOver = false;
+	bool gameWin = false;
+	float lifelineY = 0.f;
+	float dangerHeight = 0.f;
+	std::uint64_t step = 0;      // 该帧对应的 World 步数
+	std::uint64_t publishNs = 0; // 发布时刻（Profiler::now）
+
+	size_t size() const { return x.size(); }
+	void reserve(size_t n);
+	// 从 world 复制当前状态
+	void capture(const World& world);
+};
+
+// 在独立线程上以固定步长推进 World，与渲染线程完全解耦：
+// 渲染线程通过 post 投递输入（加锁的小队列，只在有输入时加锁），物理线程立即醒来，在下一个步之前依次交给 handler 处理；
+// 每推进一批固定步后把画面状态写入无锁三缓冲，渲染线程随时取最新的一帧绘制，双方都不等待对方。
+// 物理过慢时与 FixedTimestep 一样限制单次补步数，渲染的 vsync 等待也不会拖慢物理。
+// start 之后 World 只能由物理线程（包括 handler）访问，stop 返回后才能再由其他线程访问。
+class SimulationThread {
+public:
+	// 渲染线程投递的输入；type 的含义由 handler 决定
+	struct Input {
+		std::uint8_t type = 0;
+		float x = 0.f;
+		float y = 0.f;
+	};
+	using Handler = std::function<void(World&, const Input&)>;
+
+	SimulationThread(World& world, float stepSeconds, int maxCatchUpSteps);
+	~SimulationThread();
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	// handler 在物理线程上执行，必须在 start 之前设置
+	void setHandler(Handler h) { handler = std::move(h); }
+	void start();
+	void stop();
+	bool isRunning() const { return thread.joinable(); }
+
+	void post(const Input& in);
+	// 画面状态的三缓冲（渲染线程只调用 acquire / readBuffer）
+	TripleBuffer<SimFrame>& frames() { return buffer; }
+	float getStep() const { return timestep.getStep(); }
+	// 已推进的固定步数（物理线程写，任意线程读）
+	std::uint64_t getSteps() const { return steps.load(std::memory_order_relaxed); }
+
+	// 输入队列的预留容量（一批输入超过它时才会分配）
+	static constexpr size_t INPUT_CAPACITY = 64;
+
+private:
+	void loop();
+	void publish();
+
+	World& world;
+	FixedTimestep timestep;
+	Handler handler;
+	TripleBuffer<SimFrame> buffer;
+	std::thread thread;
+	std::atomic<bool> stopping{false};
+	std::atomic<std::uint64_t> steps{0};
+
+	// 输入队列：渲染线程写 pending，物理线程把它与 working 交换后处理（两者都预留容量）
+	std::mutex inputMutex;
+	std::condition_variable inputReady; // 有输入或要停止时提前结束物理线程的等待
+	std::vector<Input> pending;
+	std::vector<Input> working;
+	std::atomic<bool> hasInput{false};
+};
@@ -0,0 +1,239 @@
+#include "Snapshot.h"
+#include "World.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <limits>
+
+namespace {
+
+const char MAGIC[4] = {'S', 'B', 'S', 'S'};
+// 版本 3 起头部记录分离迭代次数与连续碰撞开关；版本 2 的快照按当时固定的 4 次迭代、无连续碰撞恢复。
+// 版本 4 起记录连锁合并开关；更早的快照没有连锁合并。
+// 版本 5 去掉了头部中不再使用的 currentSpawnLevel（更早的头部见 HeaderV4）
+const std::uint32_t VERSION = 5;
+const std::uint32_t MIN_VERSION = 2;
+
+enum StateBits : std::uint32_t {
+	GAME_OVER = 1,
+	GAME_WIN = 2,
+	SPAWN_LOCKED = 4,
+	SLEEP_ENABLED = 8,
+	SLEEP_SKYLINE_DIRTY = 16,
+	CCD_ENABLED = 32,
+	MERGE_CASCADES = 64
+};
+
+// 固定长度头部（全部为 4/8 字节字段，总长为 8 的倍数，其后的数组保持对齐）
+struct Header {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t rules;   // 规则集编号（RuleSet::id）
+	std::uint32_t passes;  // 分离求解迭代次数（版本 2 中为保留字段）
+	float width;
+	float height;
+	float lifelineY;
+	std::uint32_t maxBalls;
+	std::uint32_t substeps;
+	std::uint32_t ballCount;
+	std::uint32_t columns;
+	std::uint32_t state;
+	std::uint64_t seed;
+	std::uint64_t rngState;
+	std::uint64_t stepCount;
+	std::int32_t score;
+	std::int32_t nextSpawnLevel;
+	std::int32_t nextIsland;
+	float stackTop;
+	float sleepTop;
+	std::uint32_t padding; // 使头部长度保持 8 的倍数，写为 0
+};
+static_assert(sizeof(Header) % 8 == 0, "snapshot header must keep the arrays aligned");
+
+// 版本 2~4 的头部：nextSpawnLevel 之后多一个 currentSpawnLevel，长度与当前头部相同
+struct HeaderV4 {
+	char prefix[offsetof(Header, nextIsland)];
+	std::int32_t currentSpawnLevel;
+	std::int32_t nextIsland;
+	float stackTop;
+	float sleepTop;
+};
+static_assert(sizeof(HeaderV4) == sizeof(Header), "old and new snapshot headers share the payload layout");
+
+// 读出头部并转换为当前格式；长度不足、标识或版本不符时返回 false
+bool readHeader(const void* bytes, size_t size, Header& h)
+{
+	if (size < sizeof(Header)) return false;
+	std::memcpy(&h, bytes, sizeof(h));
+	if (std::memcmp(h.magic, MAGIC, sizeof(MAGIC)) != 0 || h.version < MIN_VERSION || h.version > VERSION) return false;
+	if (h.version < 5) {
+		HeaderV4 old;
+		std::memcpy(&old, bytes, sizeof(old));
+		h.nextIsland = old.nextIsland;
+		h.stackTop = old.stackTop;
+		h.sleepTop = old.sleepTop;
+		h.padding = 0;
+	}
+	return true;
+}
+
+const size_t FLOAT_ARRAYS = 9; // x, y, vx, vy, prevX, prevY, age, timeAboveLine, calmTime
+
+size_t payloadSize(size_t balls, size_t columns)
+{
+	return sizeof(Header) + 2 * columns * sizeof(float)
+		+ balls * (FLOAT_ARRAYS * sizeof(float) + sizeof(std::int32_t) + 2);
+}
+
+template <class T>
+unsigned char* putArray(unsigned char* p, const std::vector<T>& v, size_t n)
+{
+	std::memcpy(p, v.data(), n * sizeof(T));
+	return p + n * sizeof(T);
+}
+
+template <class T>
+const unsigned char* getArray(const unsigned char* p, std::vector<T>& v, size_t n)
+{
+	v.resize(n);
+	std::memcpy(v.data(), p, n * sizeof(T));
+	return p + n * sizeof(T);
+}
+
+} // namespace
+
+void Snapshot::capture(const World& world)
+{
+	const BallStore& b = world.balls;
+	const size_t n = b.size();
+	const size_t columns = world.skyline.size();
+
+	Header h;
+	std::memcpy(h.magic, MAGIC, sizeof(MAGIC));
+	h.version = VERSION;
+	h.rules = world.rules->id;
+	h.passes = static_cast<std::uint32_t>(world.separationPasses);
+	h.width = world.width;
+	h.height = world.height;
+	h.lifelineY = world.lifelineY;
+	h.maxBalls = static_cast<std::uint32_t>(world.MAX_BALLS);
+	h.substeps = static_cast<std::uint32_t>(world.substeps);
+	h.ballCount = static_cast<std::uint32_t>(n);
+	h.columns = static_cast<std::uint32_t>(columns);
+	h.state = (world.gameOver ? std::uint32_t(GAME_OVER) : 0u) | (world.gameWin ? std::uint32_t(GAME_WIN) : 0u)
+		| (world.spawnLocked ? std::uint32_t(SPAWN_LOCKED) : 0u) | (world.sleepEnabled ? std::uint32_t(SLEEP_ENABLED) : 0u)
+		| (world.sleepSkylineDirty ? std::uint32_t(SLEEP_SKYLINE_DIRTY) : 0u)
+		| (world.ccdEnabled ? std::uint32_t(CCD_ENABLED) : 0u)
+		| (world.mergeCascades ? std::uint32_t(MERGE_CASCADES) : 0u);
+	h.seed = world.seed;
+	h.rngState = world.rng.getState();
+	h.stepCount = world.stepCount;
+	h.score = world.score;
+	h.nextSpawnLevel = world.nextSpawnLevel;
+	h.nextIsland = world.nextIsland;
+	h.stackTop = world.stackTop;
+	h.sleepTop = world.sleepTop;
+	h.padding = 0;
+
+	data.resize(payloadSize(n, columns));
+	unsigned char* p = data.data();
+	std::memcpy(p, &h, sizeof(h));
+	p += sizeof(h);
+	p = putArray(p, world.skyline, columns);
+	p = putArray(p, world.sleepSkyline, columns);
+	const std::vector<float>* floats[FLOAT_ARRAYS] = {
+		&b.x, &b.y, &b.vx, &b.vy, &b.prevX, &b.prevY, &b.age, &b.timeAboveLine, &b.calmTime
+	};
+	for (const std::vector<float>* f : floats)
+		p = putArray(p, *f, n);
+	p = putArray(p, b.island, n);
+	p = putArray(p, b.level, n);
+	putArray(p, b.flags, n);
+}
+
+bool Snapshot::restore(World& world, const void* bytes, size_t size)
+{
+	Header h;
+	if (!readHeader(bytes, size, h)) return false;
+	if (h.rules != world.rules->id || h.width != world.width || h.height != world.height || h.maxBalls != world.MAX_BALLS
+		|| h.columns != world.skyline.size() || h.ballCount > h.maxBalls) return false;
+	// 子步数为 0 会使步长除以 0，转换为 int 后为负同样无效
+	if (h.substeps < 1 || h.substeps > static_cast<std::uint32_t>(std::numeric_limits<int>::max())) return false;
+	const size_t n = h.ballCount;
+	if (size != payloadSize(n, h.columns)) return false;
+	// 等级必须在 [1, maxLevel] 内（损坏或手工修改的文件），在改动 world 之前检查
+	const unsigned char* levels = static_cast<const unsigned char*>(bytes) + payloadSize(n, h.columns) - 2 * n;
+	for (size_t i = 0; i < n; ++i)
+		if (levels[i] < 1 || levels[i] > world.rules->maxLevel) return false;
+
+	const unsigned char* p = static_cast<const unsigned char*>(bytes) + sizeof(Header);
+	p = getArray(p, world.skyline, h.columns);
+	p = getArray(p, world.sleepSkyline, h.columns);
+	BallStore& b = world.balls;
+	std::vector<float>* floats[FLOAT_ARRAYS] = {
+		&b.x, &b.y, &b.vx, &b.vy, &b.prevX, &b.prevY, &b.age, &b.timeAboveLine, &b.calmTime
+	};
+	for (std::vector<float>* f : floats)
+		p = getArray(p, *f, n);
+	p = getArray(p, b.island, n);
+	p = getArray(p, b.level, n);
+	getArray(p, b.flags, n);
+
+	// 派生字段：半径与质量按规则集的查表由等级决定；插值起点取当前位置（恢复后画面不做插值）
+	const RuleSet& rules = *world.rules;
+	b.radius.resize(n);
+	b.mass.resize(n);
+	for (size_t i = 0; i < n; ++i) {
+		const int lvl = b.level[i];
+		b.radius[i] = rules.radius[lvl];
+		b.mass[i] = rules.mass[lvl];
+	}
+	b.startX = b.x;
+	b.startY = b.y;
+	// 句柄不写入快照：恢复前取得的句柄全部失效，恢复后的球使用新句柄
+	b.rebindHandles();
+
+	world.lifelineY = h.lifelineY;
+	world.substeps = static_cast<int>(h.substeps);
+	world.gameOver = (h.state & GAME_OVER) != 0;
+	world.gameWin = (h.state & GAME_WIN) != 0;
+	world.spawnLocked = (h.state & SPAWN_LOCKED) != 0;
+	world.sleepEnabled = (h.state & SLEEP_ENABLED) != 0;
+	world.sleepSkylineDirty = (h.state & SLEEP_SKYLINE_DIRTY) != 0;
+	world.ccdEnabled = h.version >= 3 && (h.state & CCD_ENABLED) != 0;
+	world.mergeCascades = h.version >= 4 && (h.state & MERGE_CASCADES) != 0;
+	world.separationPasses = h.version >= 3 ? std::max(1, static_cast<int>(h.passes)) : 4;
+	world.seed = h.seed;
+	world.rng.setState(h.rngState);
+	world.stepCount = h.stepCount;
+	world.score = h.score;
+	world.nextSpawnLevel = h.nextSpawnLevel;
+	world.nextIsland = h.nextIsland;
+	world.stackTop = h.stackTop;
+	world.sleepTop = h.sleepTop;
+	return true;
+}
+
+bool Snapshot::save(const std::string& path) const
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out) return false;
+	out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+	return static_cast<bool>(out);
+}
+
+bool Snapshot::load(const std::string& path)
+{
+	std::ifstream in(path, std::ios::binary | std::ios::ate);
+	if (!in) return false;
+	std::streamsize size = in.tellg();
+	if (size < static_cast<std::streamsize>(sizeof(Header))) return false;
+	in.seekg(0);
+	data.resize(static_cast<size_t>(size));
+	if (!in.read(reinterpret_cast<char*>(data.data()), size)) {
+		data.clear();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class World;
+
+// 一局游戏的完整状态快照（球、分数、随机数、预览等级、生命线计时、胜负与休眠状态），
+// 可用于回滚、存档以及搜索中的“假如”推演。
+//
+// 内存中就是文件格式本身：固定长度的头部后接各字段的连续数组，数组按 4 字节对齐，
+// 因此 save 写出的文件可以直接内存映射后交给 restore(world, data, size)，无需解析或拷贝到中间结构。
+// 恢复只是按数组整段复制，容器容量足够时不分配内存。
+//
+// 二进制格式（小端）：
+//   头部 Header（见 Snapshot.cpp）| f32 轮廓 * 列数 | f32 休眠轮廓 * 列数
+//   | f32 x, y, vx, vy, prevX, prevY, age, timeAboveLine, calmTime * 球数 | i32 island * 球数
+//   | u8 level * 球数 | u8 flags * 球数
+// 半径与质量由等级按规则集推出，不写入快照；头部记录规则集编号，只能恢复到同一规则集的 World。
+class Snapshot {
+public:
+	// 记录 world 的当前状态（缓冲区复用，大小不超过已有容量时不分配）
+	void capture(const World& world);
+	// 把快照恢复到 world；规则集、尺寸、球数上限不匹配或版本不受支持时返回 false 且不修改 world
+	// （较早版本的快照缺少的设置按其录制时的行为恢复，见 Snapshot.cpp 的 VERSION）
+	bool restore(World& world) const { return restore(world, data.data(), data.size()); }
+	// 从任意内存（例如内存映射的快照文件）恢复
+	static bool restore(World& world, const void* bytes, size_t size);
+
+	bool save(const std::string& path) const;
+	bool load(const std::string& path);
+
+	bool empty() const { return data.empty(); }
+	size_t size() const { return data.size(); }
+	const unsigned char* bytes() const { return data.data(); }
+
+private:
+	std::vector<unsigned char> data;
+};
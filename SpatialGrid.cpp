@@ -0,0 +1,32 @@
+#include "SpatialGrid.h"
+#include <algorithm>
+#include <cmath>
+
+void SpatialGrid::configure(float cellSize, float width, float height)
+{
+	cell = cellSize > 1.f ? cellSize : 1.f;
+	invCell = 1.f / cell;
+	cols = std::max(1, static_cast<int>(std::ceil(width * invCell)));
+	rows = std::max(1, static_cast<int>(std::ceil(height * invCell)));
+}
+
+void SpatialGrid::reserve(size_t count)
+{
+	const size_t cellCount = static_cast<size_t>(cols) * rows;
+	cellStart.reserve(cellCount + 1);
+	fill.reserve(cellCount);
+	items.reserve(count);
+	itemCell.reserve(count);
+}
+
+int SpatialGrid::cellX(float x) const
+{
+	int c = static_cast<int>(std::floor(x * invCell));
+	return c < 0 ? 0 : (c >= cols ? cols - 1 : c);
+}
+
+int SpatialGrid::cellY(float y) const
+{
+	int c = static_cast<int>(std::floor(y * invCell));
+	return c < 0 ? 0 : (c >= rows ? rows - 1 : c);
+}
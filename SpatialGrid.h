@@ -0,0 +1,128 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+// 均匀网格宽相（broad phase）
+// 格子边长不小于最大交互距离（最大球直径 + 容差），因此任何可能接触的两球
+// 必然落在彼此相邻的 3x3 格子内，每个球只需检查常数个格子。
+// 内部以计数排序存储（cellStart 前缀和 + items），重建为 O(n)，且复用缓冲区不反复分配。
+class SpatialGrid {
+public:
+	// 设置覆盖区域 [0,width) x [0,height) 与格子边长；区域外的点被夹到边界格子
+	void configure(float cellSize, float width, float height);
+
+	// 按当前区域与最多 count 个对象预留缓冲区，之后的 build 不再分配内存
+	void reserve(size_t count);
+
+	// 重建网格：getPos(k) 返回带 x/y 成员的位置，skip(k) 为 true 的对象不入格
+	template <class GetPos, class Skip>
+	void build(size_t count, GetPos getPos, Skip skip);
+
+	// 对 (x, y) 所在格子及其 8 邻格中的每个对象下标调用 f(k)
+	template <class F>
+	void query(float x, float y, F&& f) const;
+
+	// 与 query 相同的邻域，f(k) 返回 true 时立即停止并返回 true
+	template <class F>
+	bool any(float x, float y, F&& f) const;
+
+	// 对中心可能落在矩形 [x0, x1] x [y0, y1] 内的每个对象下标调用 f(k)（按格子粒度，可能多报）
+	template <class F>
+	void queryRect(float x0, float y0, float x1, float y1, F&& f) const;
+
+	float getCellSize() const { return cell; }
+
+private:
+	int cellX(float x) const;
+	int cellY(float y) const;
+
+	float cell = 1.f;
+	float invCell = 1.f;
+	int cols = 1;
+	int rows = 1;
+	std::vector<int> cellStart; // 大小 cols*rows+1，格子 c 的对象为 items[cellStart[c]..cellStart[c+1])
+	std::vector<int> items;
+	std::vector<int> itemCell;  // 每个对象所在格子（-1 表示跳过）
+	std::vector<int> fill;      // 散列写入时每个格子的写指针
+};
+
+template <class GetPos, class Skip>
+void SpatialGrid::build(size_t count, GetPos getPos, Skip skip)
+{
+	const int cellCount = cols * rows;
+	cellStart.assign(cellCount + 1, 0);
+	itemCell.resize(count);
+
+	// 第一遍：统计每个格子的对象数量
+	int live = 0;
+	for (size_t k = 0; k < count; ++k) {
+		if (skip(k)) { itemCell[k] = -1; continue; }
+		auto p = getPos(k);
+		int c = cellY(p.y) * cols + cellX(p.x);
+		itemCell[k] = c;
+		++cellStart[c + 1];
+		++live;
+	}
+	// 前缀和得到每个格子的起始位置
+	for (int c = 0; c < cellCount; ++c) cellStart[c + 1] += cellStart[c];
+
+	// 第二遍：按格子散列写入（保持下标递增顺序，结果确定）
+	items.resize(live);
+	fill.assign(cellStart.begin(), cellStart.end() - 1);
+	for (size_t k = 0; k < count; ++k) {
+		int c = itemCell[k];
+		if (c < 0) continue;
+		items[fill[c]++] = static_cast<int>(k);
+	}
+}
+
+template <class F>
+void SpatialGrid::query(float x, float y, F&& f) const
+{
+	if (items.empty()) return;
+	const int cx = cellX(x);
+	const int cy = cellY(y);
+	const int x0 = cx > 0 ? cx - 1 : 0;
+	const int x1 = cx < cols - 1 ? cx + 1 : cols - 1;
+	const int y0 = cy > 0 ? cy - 1 : 0;
+	const int y1 = cy < rows - 1 ? cy + 1 : rows - 1;
+	for (int gy = y0; gy <= y1; ++gy) {
+		// 同一行的相邻格子在 items 中是连续的一段
+		const int begin = cellStart[gy * cols + x0];
+		const int end = cellStart[gy * cols + x1 + 1];
+		for (int s = begin; s < end; ++s) f(items[s]);
+	}
+}
+
+template <class F>
+bool SpatialGrid::any(float x, float y, F&& f) const
+{
+	if (items.empty()) return false;
+	const int cx = cellX(x);
+	const int cy = cellY(y);
+	const int x0 = cx > 0 ? cx - 1 : 0;
+	const int x1 = cx < cols - 1 ? cx + 1 : cols - 1;
+	const int y0 = cy > 0 ? cy - 1 : 0;
+	const int y1 = cy < rows - 1 ? cy + 1 : rows - 1;
+	for (int gy = y0; gy <= y1; ++gy) {
+		const int begin = cellStart[gy * cols + x0];
+		const int end = cellStart[gy * cols + x1 + 1];
+		for (int s = begin; s < end; ++s)
+			if (f(items[s])) return true;
+	}
+	return false;
+}
+
+template <class F>
+void SpatialGrid::queryRect(float x0, float y0, float x1, float y1, F&& f) const
+{
+	if (items.empty()) return;
+	const int cx0 = cellX(x0), cx1 = cellX(x1);
+	const int cy0 = cellY(y0), cy1 = cellY(y1);
+	for (int gy = cy0; gy <= cy1; ++gy) {
+		const int begin = cellStart[gy * cols + cx0];
+		const int end = cellStart[gy * cols + cx1 + 1];
+		for (int s = begin; s < end; ++s) f(items[s]);
+	}
+}
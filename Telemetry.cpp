@@ -0,0 +1,524 @@
+#include "Telemetry.h"
+#include "World.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace Telemetry;
+
+namespace {
+
+const char FILE_MAGIC[4] = {'S', 'B', 'T', 'L'};
+const char CHUNK_MAGIC[4] = {'C', 'H', 'N', 'K'};
+// 槽位上限（解码时拒绝损坏数据导致的超大预测表）
+const std::int64_t MAX_SLOT = 1 << 24;
+
+static_assert(sizeof(FileHeader) == 32, "telemetry file header layout");
+static_assert(sizeof(ChunkHeader) % 8 == 0, "telemetry chunk header layout");
+
+// 步号差与合并次数直接写出，其余步列以上一步的值为预测
+bool deltaCoded(Column c)
+{
+	return c != StepDelta && c != Merges;
+}
+
+std::uint32_t fnv1a(std::uint32_t h, const unsigned char* p, size_t n)
+{
+	for (size_t i = 0; i < n; ++i) h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+const std::uint32_t FNV_BASIS = 2166136261u;
+
+std::int64_t quantize(float v, float scale)
+{
+	return static_cast<std::int64_t>(std::llround(static_cast<double>(v) * scale));
+}
+
+// 残差编码：zigzag 后按 7 位一组的变长整数写出；0 不单独写出，连续的 0 写成 0 加游程长度减 1
+class ColumnWriter {
+public:
+	explicit ColumnWriter(std::vector<unsigned char>& o) : out(o) {}
+	~ColumnWriter() { flush(); }
+
+	void put(std::int64_t residual)
+	{
+		if (residual == 0) {
+			++zeros;
+			return;
+		}
+		flush();
+		varint((static_cast<std::uint64_t>(residual) << 1) ^ static_cast<std::uint64_t>(residual >> 63));
+	}
+
+	void flush()
+	{
+		if (zeros == 0) return;
+		varint(0);
+		varint(zeros - 1);
+		zeros = 0;
+	}
+
+private:
+	void varint(std::uint64_t v)
+	{
+		while (v >= 0x80) {
+			out.push_back(static_cast<unsigned char>(v | 0x80));
+			v >>= 7;
+		}
+		out.push_back(static_cast<unsigned char>(v));
+	}
+
+	std::vector<unsigned char>& out;
+	std::uint64_t zeros = 0;
+};
+
+class ColumnReader {
+public:
+	ColumnReader(const unsigned char* begin, const unsigned char* end) : p(begin), last(end) {}
+
+	bool get(std::int64_t& residual)
+	{
+		if (zeros > 0) {
+			--zeros;
+			residual = 0;
+			return true;
+		}
+		std::uint64_t v;
+		if (!varint(v)) return false;
+		if (v == 0) {
+			if (!varint(zeros)) return false;
+			residual = 0;
+			return true;
+		}
+		residual = static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+		return true;
+	}
+
+	// 整列恰好用完（没有多余的字节或未用完的游程）
+	bool done() const { return p == last && zeros == 0; }
+
+private:
+	bool varint(std::uint64_t& v)
+	{
+		v = 0;
+		for (int shift = 0; shift < 64; shift += 7) {
+			if (p == last) return false;
+			const unsigned char b = *p++;
+			v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+			if (!(b & 0x80)) return true;
+		}
+		return false;
+	}
+
+	const unsigned char* p;
+	const unsigned char* last;
+	std::uint64_t zeros = 0;
+};
+
+} // namespace
+
+const char* Telemetry::columnName(Column c)
+{
+	static const char* const NAMES[COLUMN_COUNT] = {
+		"step_delta", "ball_count", "contacts", "merges", "max_overlap", "sum_overlap", "above_line",
+		"max_time_above", "score", "step_flags", "slot", "generation", "level", "x", "y", "vx", "vy", "ball_flags"
+	};
+	return c < COLUMN_COUNT ? NAMES[c] : "?";
+}
+
+TelemetryWriter::TelemetryWriter()
+	: TelemetryWriter(Config())
+{
+}
+
+TelemetryWriter::TelemetryWriter(const Config& cfg)
+	: config(cfg)
+{
+	if (config.stepsPerChunk < 1) config.stepsPerChunk = 1;
+	if (config.buffers < 2) config.buffers = 2;
+}
+
+TelemetryWriter::~TelemetryWriter()
+{
+	close();
+}
+
+bool TelemetryWriter::open(const std::string& path, const RuleSet& rules, float stepSeconds, size_t maxBalls)
+{
+	close();
+	out.open(path, std::ios::binary | std::ios::trunc);
+	if (!out) return false;
+
+	FileHeader head = {};
+	std::memcpy(head.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+	head.version = VERSION;
+	head.rules = rules.id;
+	head.maxBalls = static_cast<std::uint32_t>(maxBalls);
+	head.stepsPerChunk = static_cast<std::uint32_t>(config.stepsPerChunk);
+	head.stepSeconds = stepSeconds;
+	head.lifelineY = rules.lifelineY;
+	out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+
+	// 全部块缓冲一次预留到最大容量，record 之后不再分配
+	buffers.reset(new Buffer[config.buffers]);
+	freeList.clear();
+	queue.clear();
+	freeList.reserve(config.buffers);
+	queue.reserve(config.buffers);
+	for (size_t i = 0; i < config.buffers; ++i) {
+		buffers[i].steps.reserve(config.stepsPerChunk);
+		buffers[i].rows.reserve(config.stepsPerChunk * maxBalls);
+		freeList.push_back(&buffers[i]);
+	}
+	current = nullptr;
+	run = 0;
+	recordedSteps = droppedSteps = 0;
+	writtenChunks = 0;
+	writtenBytes = sizeof(head);
+	writeError = !out;
+	stopping = false;
+	writer = std::thread(&TelemetryWriter::writerLoop, this);
+	return true;
+}
+
+void TelemetryWriter::close()
+{
+	if (!out.is_open()) return;
+	if (current && !current->steps.empty()) {
+		submit();
+	} else if (current) {
+		std::lock_guard<std::mutex> lock(mutex);
+		freeList.push_back(current);
+		current = nullptr;
+	}
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	ready.notify_one();
+	writer.join();
+	out.close();
+	if (out.fail()) writeError = true;
+}
+
+void TelemetryWriter::record(const World& world)
+{
+	if (!out.is_open()) return;
+	if (!current) {
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!config.dropWhenBehind) released.wait(lock, [&] { return !freeList.empty(); });
+		if (!freeList.empty()) {
+			current = freeList.back();
+			freeList.pop_back();
+		}
+	}
+	if (!current) {
+		// 写线程跟不上：丢弃这一步，下一步再尝试取空闲缓冲
+		++droppedSteps;
+		return;
+	}
+	if (current->steps.empty()) current->run = run;
+
+	const BallStore& b = world.getBalls();
+	const World::StepStats& stats = world.getStepStats();
+	const float lifelineY = world.getLifelineY();
+	StepRow s;
+	s.step = world.getStepCount();
+	s.balls = static_cast<std::uint32_t>(b.size());
+	s.contacts = stats.contacts;
+	s.merges = stats.merges;
+	s.aboveLine = 0;
+	s.maxOverlap = stats.maxOverlap;
+	s.sumOverlap = stats.sumOverlap;
+	s.maxTimeAbove = 0.f;
+	s.score = world.getScore();
+	s.flags = (world.isGameOver() ? GAME_OVER : 0u) | (world.isGameWin() ? GAME_WIN : 0u)
+		| (world.isSpawnLocked() ? SPAWN_LOCKED : 0u);
+	for (size_t i = 0; i < b.size(); ++i) {
+		const BallStore::Handle h = b.handle(i);
+		current->rows.push_back({h.slot, h.generation, b.x[i], b.y[i], b.vx[i], b.vy[i], b.level[i], b.flags[i]});
+		if (b.y[i] - b.radius[i] <= lifelineY) ++s.aboveLine;
+		s.maxTimeAbove = std::max(s.maxTimeAbove, b.timeAboveLine[i]);
+	}
+	current->steps.push_back(s);
+	++recordedSteps;
+	if (current->steps.size() >= config.stepsPerChunk) submit();
+}
+
+void TelemetryWriter::nextRun()
+{
+	if (current && !current->steps.empty()) submit();
+	++run;
+}
+
+void TelemetryWriter::submit()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(current);
+		current = nullptr;
+	}
+	ready.notify_one();
+}
+
+// 写线程：按提交顺序编码并写出各块，写完的缓冲放回空闲表；停止时先写完队列中剩余的块
+void TelemetryWriter::writerLoop()
+{
+	for (;;) {
+		Buffer* buf;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			ready.wait(lock, [&] { return stopping || !queue.empty(); });
+			if (queue.empty()) return;
+			buf = queue.front();
+			queue.erase(queue.begin());
+		}
+		encode(*buf);
+		buf->steps.clear();
+		buf->rows.clear();
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			freeList.push_back(buf);
+		}
+		released.notify_one();
+	}
+}
+
+void TelemetryWriter::encode(const Buffer& buf)
+{
+	for (auto& e : encoded) e.clear();
+
+	// 步列
+	for (int c = 0; c < FIRST_BALL_COLUMN; ++c) {
+		ColumnWriter w(encoded[c]);
+		std::int64_t prev = 0;
+		std::uint64_t lastStep = buf.steps.front().step - 1;
+		for (const StepRow& s : buf.steps) {
+			std::int64_t v = 0;
+			switch (c) {
+			case StepDelta: v = static_cast<std::int64_t>(s.step - lastStep - 1); break;
+			case BallCount: v = s.balls; break;
+			case Contacts: v = s.contacts; break;
+			case Merges: v = s.merges; break;
+			case MaxOverlap: v = quantize(s.maxOverlap, OVERLAP_SCALE); break;
+			case SumOverlap: v = quantize(s.sumOverlap, OVERLAP_SCALE); break;
+			case AboveLine: v = s.aboveLine; break;
+			case MaxTimeAbove: v = quantize(s.maxTimeAbove, 1000.f); break;
+			case Score: v = s.score; break;
+			case StepFlags: v = s.flags; break;
+			}
+			lastStep = s.step;
+			w.put(deltaCoded(static_cast<Column>(c)) ? v - prev : v);
+			prev = v;
+		}
+	}
+	// 球列：槽位以上一步同一行的槽位为预测
+	std::uint32_t maxSlot = 0;
+	{
+		ColumnWriter w(encoded[Slot]);
+		rowSlots.clear();
+		size_t row = 0;
+		for (const StepRow& s : buf.steps) {
+			for (size_t k = 0; k < s.balls; ++k, ++row) {
+				const std::int64_t slot = buf.rows[row].slot;
+				if (k < rowSlots.size()) {
+					w.put(slot - rowSlots[k]);
+					rowSlots[k] = slot;
+				} else {
+					w.put(slot);
+					rowSlots.push_back(slot);
+				}
+				maxSlot = std::max(maxSlot, buf.rows[row].slot);
+			}
+			rowSlots.resize(s.balls);
+		}
+	}
+	for (int c = Generation; c < COLUMN_COUNT; ++c) {
+		ColumnWriter w(encoded[c]);
+		predicted.assign(static_cast<size_t>(maxSlot) + 1, 0);
+		for (const BallRow& r : buf.rows) {
+			std::int64_t v = 0;
+			switch (c) {
+			case Generation: v = r.generation; break;
+			case Level: v = r.level; break;
+			case X: v = quantize(r.x, POSITION_SCALE); break;
+			case Y: v = quantize(r.y, POSITION_SCALE); break;
+			case VX: v = quantize(r.vx, VELOCITY_SCALE); break;
+			case VY: v = quantize(r.vy, VELOCITY_SCALE); break;
+			case BallFlags: v = r.flags; break;
+			}
+			w.put(v - predicted[r.slot]);
+			predicted[r.slot] = v;
+		}
+	}
+
+	ChunkHeader head = {};
+	std::memcpy(head.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC));
+	head.run = buf.run;
+	head.firstStep = buf.steps.front().step;
+	head.steps = static_cast<std::uint32_t>(buf.steps.size());
+	head.rows = static_cast<std::uint32_t>(buf.rows.size());
+	size_t bytes = sizeof(head);
+	for (int c = 0; c < COLUMN_COUNT; ++c) {
+		head.columnBytes[c] = static_cast<std::uint32_t>(encoded[c].size());
+		bytes += encoded[c].size();
+	}
+	std::uint32_t sum = fnv1a(FNV_BASIS, reinterpret_cast<const unsigned char*>(&head), sizeof(head));
+	for (const auto& e : encoded) sum = fnv1a(sum, e.data(), e.size());
+	head.checksum = sum;
+	out.write(reinterpret_cast<const char*>(&head), sizeof(head));
+	for (const auto& e : encoded) out.write(reinterpret_cast<const char*>(e.data()), static_cast<std::streamsize>(e.size()));
+	if (!out) writeError = true;
+	++writtenChunks;
+	writtenBytes += bytes;
+}
+
+bool TelemetryReader::open(const std::string& path)
+{
+	offset = 0;
+	truncated = false;
+	message.clear();
+	if (!file.open(path)) {
+		message = "cannot open " + path;
+		return false;
+	}
+	file.adviseSequential();
+	if (file.size() < sizeof(FileHeader)) {
+		message = "file too short";
+		return false;
+	}
+	std::memcpy(&head, file.data(), sizeof(head));
+	if (std::memcmp(head.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0) {
+		message = "not a telemetry file";
+		return false;
+	}
+	if (head.version != VERSION) {
+		message = "unsupported telemetry version " + std::to_string(head.version);
+		return false;
+	}
+	offset = sizeof(FileHeader);
+	return true;
+}
+
+bool TelemetryReader::next(Chunk& chunk)
+{
+	if (!file.isOpen() || !message.empty()) return false;
+	const size_t size = file.size();
+	if (offset + sizeof(ChunkHeader) > size) {
+		truncated = offset != size;
+		return false;
+	}
+	ChunkHeader ch;
+	std::memcpy(&ch, file.data() + offset, sizeof(ch));
+	if (std::memcmp(ch.magic, CHUNK_MAGIC, sizeof(CHUNK_MAGIC)) != 0) {
+		message = "bad chunk header at offset " + std::to_string(offset);
+		return false;
+	}
+	size_t bytes = sizeof(ch);
+	for (std::uint32_t b : ch.columnBytes) bytes += b;
+	if (offset + bytes > size) {
+		// 写到一半的最后一块（例如进程被中断）
+		truncated = true;
+		return false;
+	}
+	if (ch.rows > static_cast<std::uint64_t>(ch.steps) * head.maxBalls) {
+		message = "bad row count at offset " + std::to_string(offset);
+		return false;
+	}
+
+	{
+		ChunkHeader zeroed = ch;
+		zeroed.checksum = 0;
+		std::uint32_t sum = fnv1a(FNV_BASIS, reinterpret_cast<const unsigned char*>(&zeroed), sizeof(zeroed));
+		sum = fnv1a(sum, file.data() + offset + sizeof(ch), bytes - sizeof(ch));
+		if (sum != ch.checksum) {
+			message = "checksum mismatch at offset " + std::to_string(offset);
+			return false;
+		}
+	}
+
+	chunk.run = ch.run;
+	chunk.firstStep = ch.firstStep;
+	chunk.steps = ch.steps;
+	chunk.rows = ch.rows;
+	chunk.encodedBytes = bytes;
+
+	const unsigned char* p = file.data() + offset + sizeof(ch);
+	const unsigned char* begin[COLUMN_COUNT];
+	for (int c = 0; c < COLUMN_COUNT; ++c) {
+		begin[c] = p;
+		p += ch.columnBytes[c];
+	}
+	auto fail = [&]() {
+		message = "corrupt chunk at offset " + std::to_string(offset);
+		return false;
+	};
+
+	// 步列
+	std::uint64_t rows = 0;
+	for (int c = 0; c < FIRST_BALL_COLUMN; ++c) {
+		ColumnReader r(begin[c], begin[c] + ch.columnBytes[c]);
+		std::vector<std::int64_t>& col = chunk.columns[c];
+		col.resize(ch.steps);
+		std::int64_t prev = 0;
+		for (std::uint32_t s = 0; s < ch.steps; ++s) {
+			std::int64_t v;
+			if (!r.get(v)) return fail();
+			if (deltaCoded(static_cast<Column>(c))) v += prev;
+			col[s] = prev = v;
+		}
+		if (!r.done()) return fail();
+	}
+	for (std::int64_t n : chunk.columns[BallCount]) {
+		if (n < 0) return fail();
+		rows += static_cast<std::uint64_t>(n);
+	}
+	if (rows != ch.rows) return fail();
+
+	// 槽位：以上一步同一行的槽位为预测
+	std::int64_t maxSlot = 0;
+	{
+		ColumnReader r(begin[Slot], begin[Slot] + ch.columnBytes[Slot]);
+		std::vector<std::int64_t>& col = chunk.columns[Slot];
+		col.resize(ch.rows);
+		rowSlots.clear();
+		size_t row = 0;
+		for (std::uint32_t s = 0; s < ch.steps; ++s) {
+			const size_t n = static_cast<size_t>(chunk.columns[BallCount][s]);
+			for (size_t k = 0; k < n; ++k, ++row) {
+				std::int64_t v;
+				if (!r.get(v)) return fail();
+				if (k < rowSlots.size()) {
+					v += rowSlots[k];
+					rowSlots[k] = v;
+				} else {
+					rowSlots.push_back(v);
+				}
+				if (v < 0 || v >= MAX_SLOT) return fail();
+				col[row] = v;
+				maxSlot = std::max(maxSlot, v);
+			}
+			rowSlots.resize(n);
+		}
+		if (!r.done()) return fail();
+	}
+	// 其余球列：以上一步同一槽位的值为预测
+	const std::vector<std::int64_t>& slots = chunk.columns[Slot];
+	for (int c = Generation; c < COLUMN_COUNT; ++c) {
+		ColumnReader r(begin[c], begin[c] + ch.columnBytes[c]);
+		std::vector<std::int64_t>& col = chunk.columns[c];
+		col.resize(ch.rows);
+		predicted.assign(static_cast<size_t>(maxSlot) + 1, 0);
+		for (std::uint32_t i = 0; i < ch.rows; ++i) {
+			std::int64_t v;
+			if (!r.get(v)) return fail();
+			std::int64_t& pred = predicted[static_cast<size_t>(slots[i])];
+			col[i] = pred = pred + v;
+		}
+		if (!r.done()) return fail();
+	}
+
+	offset += bytes;
+	return true;
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MappedFile.h"
+
+class World;
+struct RuleSet;
+
+// 逐步遥测：每个固定步之后的全部球状态与本步的求解统计，供调参时离线分析堆的演化。
+//
+// 文件格式（小端）：FileHeader 后接若干块，每块为 ChunkHeader 加各列的编码数据（按 Column 顺序连续存放）。
+// 块内按列存储：步列每步一个值，球列每个球每步一个值（按步、步内按球下标排列，每步的行数见 BallCount 列）。
+// 浮点量先量化为定点整数（见 *_SCALE），再减去预测值（步列取上一步，Slot 取上一步同一行，
+// 其余球列取上一步同一槽位的球），残差经 zigzag 后按变长整数写出，连续的 0 合并为一个游程。
+// 静止的堆逐步几乎不变，残差大多为 0，因此压缩率很高。预测状态在块首清零，每块可以独立解码。
+namespace Telemetry {
+
+const std::uint32_t VERSION = 1;
+
+enum Column {
+	// 步列
+	StepDelta,     // 与上一步的步号差减 1（连续记录时为 0）
+	BallCount,     // 本步的球数（行数）
+	Contacts,      // World::StepStats::contacts
+	Merges,        // World::StepStats::merges
+	MaxOverlap,    // 剩余穿透最大值（OVERLAP_SCALE）
+	SumOverlap,    // 剩余穿透之和（OVERLAP_SCALE）
+	AboveLine,     // 球顶在生命线之上的球数
+	MaxTimeAbove,  // 球在生命线之上的最长持续时间（毫秒）
+	Score,
+	StepFlags,     // GAME_OVER | GAME_WIN | SPAWN_LOCKED
+	// 球列
+	Slot,          // 句柄槽位
+	Generation,    // 句柄代数（与槽位一起唯一标识一个球）
+	Level,
+	X, Y,          // 位置（POSITION_SCALE）
+	VX, VY,        // 速度（VELOCITY_SCALE）
+	BallFlags,     // BallStore::flags
+	COLUMN_COUNT
+};
+const Column FIRST_BALL_COLUMN = Slot;
+
+enum StepFlag : std::uint32_t { GAME_OVER = 1, GAME_WIN = 2, SPAWN_LOCKED = 4 };
+
+// 定点量化比例
+const float POSITION_SCALE = 64.f;   // 1/64 像素
+const float VELOCITY_SCALE = 16.f;   // 1/16 像素/秒
+const float OVERLAP_SCALE = 1024.f;  // 1/1024 像素
+
+const char* columnName(Column c);
+
+struct FileHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t rules;          // 规则集编号（RuleSet::id）
+	std::uint32_t maxBalls;
+	std::uint32_t stepsPerChunk;
+	float stepSeconds;
+	float lifelineY;
+	std::uint32_t reserved;
+};
+
+struct ChunkHeader {
+	char magic[4];
+	std::uint32_t run;            // 段号（例如基准测试的第几个场景）
+	std::uint64_t firstStep;      // 第一步的 World 步号
+	std::uint32_t steps;
+	std::uint32_t rows;           // 球列的行数（各步球数之和）
+	std::uint32_t checksum;       // 块头（本字段按 0 计）与编码数据的 FNV-1a 校验和
+	std::uint32_t reserved;
+	std::uint32_t columnBytes[COLUMN_COUNT];
+};
+
+// 解码后的一块：每列为量化后的整数
+struct Chunk {
+	std::uint32_t run = 0;
+	std::uint64_t firstStep = 0;
+	std::uint32_t steps = 0;
+	std::uint32_t rows = 0;
+	size_t encodedBytes = 0;      // 块头加编码数据的字节数
+	std::vector<std::int64_t> columns[COLUMN_COUNT];
+};
+
+} // namespace Telemetry
+
+// 后台写出的遥测记录器。record 在模拟线程上每步调用一次，只把原始值复制进预先分配的块缓冲（不编码、不分配、不做 I/O），
+// 块写满后交给写线程编码并写盘；写线程落后、空闲缓冲用完时按步丢弃并计数，而不是让模拟等待
+// （离线的基准测试与重放更在意记录完整，可以关闭丢弃，改为在块边界等待写线程）。
+// record 只能由一个线程调用；open / close 与 record 不能并发。
+class TelemetryWriter {
+public:
+	struct Config {
+		size_t stepsPerChunk = 256;
+		size_t buffers = 4;       // 块缓冲个数（1 个在填充，其余排队等待写出）
+		bool dropWhenBehind = true;
+	};
+
+	TelemetryWriter();
+	explicit TelemetryWriter(const Config& cfg);
+	~TelemetryWriter();
+	TelemetryWriter(const TelemetryWriter&) = delete;
+	TelemetryWriter& operator=(const TelemetryWriter&) = delete;
+
+	// 创建文件并启动写线程；块缓冲按 maxBalls（各 World 球数上限中最大的）预留
+	bool open(const std::string& path, const RuleSet& rules, float stepSeconds, size_t maxBalls);
+	// 写出未满的块，等待写线程写完全部块后关闭文件
+	void close();
+	bool isOpen() const { return out.is_open(); }
+
+	// 记录 world 刚推进完的一步
+	void record(const World& world);
+	// 开始新的一段：当前块提前结束，之后的块带新的段号（同一文件记录多个互不相关的 World）
+	void nextRun();
+
+	std::uint64_t getRecordedSteps() const { return recordedSteps; }
+	std::uint64_t getDroppedSteps() const { return droppedSteps; }
+	// 写线程已写出的块数与字节数（close 之后读取）
+	std::uint64_t getWrittenChunks() const { return writtenChunks; }
+	std::uint64_t getWrittenBytes() const { return writtenBytes; }
+	bool hasWriteError() const { return writeError; }
+
+private:
+	struct StepRow {
+		std::uint64_t step;
+		std::uint32_t balls;
+		std::uint32_t contacts;
+		std::uint32_t merges;
+		std::uint32_t aboveLine;
+		float maxOverlap;
+		float sumOverlap;
+		float maxTimeAbove;
+		std::int32_t score;
+		std::uint32_t flags;
+	};
+	struct BallRow {
+		std::uint32_t slot;
+		std::uint32_t generation;
+		float x, y, vx, vy;
+		std::uint8_t level;
+		std::uint8_t flags;
+	};
+	struct Buffer {
+		std::uint32_t run = 0;
+		std::vector<StepRow> steps;
+		std::vector<BallRow> rows;
+	};
+
+	void submit();
+	void writerLoop();
+	void encode(const Buffer& buf);
+
+	Config config;
+	std::ofstream out;
+	std::unique_ptr<Buffer[]> buffers;
+	Buffer* current = nullptr;
+	std::uint32_t run = 0;
+	std::uint64_t recordedSteps = 0;
+	std::uint64_t droppedSteps = 0;
+
+	// 空闲与待写出的缓冲（只在块边界加锁）
+	std::mutex mutex;
+	std::condition_variable ready;     // 有块待写出（或要停止）
+	std::condition_variable released;  // 有缓冲写完放回空闲表
+	std::vector<Buffer*> freeList;
+	std::vector<Buffer*> queue;
+	bool stopping = false;
+	std::thread writer;
+
+	// 以下只由写线程访问（close 之后可读）
+	std::vector<unsigned char> encoded[Telemetry::COLUMN_COUNT];
+	std::vector<std::int64_t> predicted;  // 按槽位的预测值
+	std::vector<std::int64_t> rowSlots;   // 上一步各行的槽位
+	std::uint64_t writtenChunks = 0;
+	std::uint64_t writtenBytes = 0;
+	bool writeError = false;
+};
+
+// 遥测文件的读取：整个文件内存映射，逐块解码（解码缓冲复用），适合顺序扫描很大的文件
+class TelemetryReader {
+public:
+	bool open(const std::string& path);
+	const Telemetry::FileHeader& header() const { return head; }
+	size_t fileSize() const { return file.size(); }
+
+	// 解码下一块；文件结束时返回 false（末尾不完整的块视为结束，见 isTruncated）
+	bool next(Telemetry::Chunk& chunk);
+	bool isTruncated() const { return truncated; }
+	// 出错原因（头部无效、块数据损坏）；为空表示正常结束
+	const std::string& error() const { return message; }
+
+private:
+	MappedFile file;
+	Telemetry::FileHeader head = {};
+	size_t offset = 0;
+	bool truncated = false;
+	std::string message;
+	std::vector<std::int64_t> predicted;
+	std::vector<std::int64_t> rowSlots;
+};
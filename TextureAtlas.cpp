@@ -0,0 +1,212 @@
+#include "TextureAtlas.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+
+namespace {
+
+const char CACHE_MAGIC[4] = {'S', 'B', 'A', 'C'};
+const std::uint32_t CACHE_VERSION = 1;
+
+// 缓存头部，其后是 SLOTS 个格子的 RGBA 像素（每格 tile * tile * 4 字节）
+struct CacheHeader {
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t tile;
+	std::uint32_t slots;
+	std::uint32_t loadedMask;
+	std::uint32_t reserved;
+	std::uint64_t stamps[TextureAtlas::SLOTS];
+};
+
+std::string sourcePath(const std::string& dir, int slot)
+{
+	return dir + "/" + std::to_string(slot) + ".png";
+}
+
+// 源文件的大小与修改时间摘要；文件不存在时为 0
+std::uint64_t sourceStamp(const std::string& path)
+{
+	std::error_code ec;
+	std::uintmax_t size = std::filesystem::file_size(path, ec);
+	if (ec) return 0;
+	auto mtime = std::filesystem::last_write_time(path, ec);
+	if (ec) return 0;
+	std::uint64_t t = static_cast<std::uint64_t>(mtime.time_since_epoch().count());
+	return (static_cast<std::uint64_t>(size) * 0x9e3779b97f4a7c15ull) ^ t;
+}
+
+} // namespace
+
+TextureAtlas::~TextureAtlas()
+{
+	if (worker.joinable()) worker.join();
+}
+
+void TextureAtlas::beginLoad(const std::string& dir)
+{
+	if (worker.joinable()) worker.join();
+	// 最大球直径约 200px，256 的格子足够清晰；显卡纹理尺寸不够时退到 128
+	tile = sf::Texture::getMaximumSize() >= 1024 ? 256 : 128;
+	const unsigned rows = (SLOTS + columns - 1) / columns;
+	texture.create(columns * tile, rows * tile);
+	texture.setSmooth(true); // 开启平滑更美观
+
+	for (int i = 0; i < SLOTS; ++i) {
+		loaded[i] = uploaded[i] = decoded[i] = false;
+		ready[i].store(false, std::memory_order_relaxed);
+		stamps[i] = i > 0 ? sourceStamp(sourcePath(dir, i)) : 0;
+	}
+	complete = false;
+	fromCache = false;
+	cachePath = dir + "/atlas.cache";
+
+	// 0 号格子固定为白色圆盘，立即可用
+	tiles.assign(tileBytes() * SLOTS, 0);
+	blitDisc(nullptr, tiles.data(), tile);
+	uploadTile(0, tiles.data());
+	uploaded[0] = true;
+
+	if (loadCache(cachePath)) {
+		fromCache = true;
+		complete = true;
+		tiles.clear();
+		tiles.shrink_to_fit();
+		return;
+	}
+	ready[0].store(true, std::memory_order_release);
+	workerDone.store(false, std::memory_order_relaxed);
+	worker = std::thread(&TextureAtlas::decodeAll, this, dir);
+}
+
+bool TextureAtlas::update()
+{
+	if (complete) return true;
+	bool all = true;
+	for (int i = 1; i < SLOTS; ++i) {
+		if (uploaded[i]) continue;
+		if (!ready[i].load(std::memory_order_acquire)) { all = false; continue; }
+		if (decoded[i]) uploadTile(i, tiles.data() + tileBytes() * i);
+		loaded[i] = decoded[i];
+		uploaded[i] = true;
+	}
+	// 全部格子已上传后还要等后台线程写完缓存，才能释放像素
+	if (!all || !workerDone.load(std::memory_order_acquire)) return false;
+	worker.join();
+	tiles.clear();
+	tiles.shrink_to_fit();
+	complete = true;
+	return true;
+}
+
+sf::FloatRect TextureAtlas::getRect(int level) const
+{
+	int slot = hasImage(level) ? level : 0;
+	float ox = static_cast<float>((slot % columns) * tile + PAD);
+	float oy = static_cast<float>((slot / columns) * tile + PAD);
+	float size = static_cast<float>(tile - 2 * PAD);
+	return sf::FloatRect(ox, oy, size, size);
+}
+
+void TextureAtlas::uploadTile(int slot, const sf::Uint8* data)
+{
+	texture.update(data, tile, tile, (slot % columns) * tile, (slot / columns) * tile);
+}
+
+// 热启动：缓存头部与当前格子尺寸、源文件摘要都一致时，直接从映射的文件上传各格子
+bool TextureAtlas::loadCache(const std::string& path)
+{
+	MappedFile file;
+	if (!file.open(path) || file.size() != sizeof(CacheHeader) + tileBytes() * SLOTS) return false;
+	CacheHeader h;
+	std::memcpy(&h, file.data(), sizeof(h));
+	if (std::memcmp(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 || h.version != CACHE_VERSION
+		|| h.tile != tile || h.slots != SLOTS || std::memcmp(h.stamps, stamps, sizeof(stamps)) != 0) return false;
+	const sf::Uint8* pixels = file.data() + sizeof(CacheHeader);
+	for (int i = 1; i < SLOTS; ++i) {
+		loaded[i] = uploaded[i] = (h.loadedMask >> i) & 1u;
+		if (loaded[i]) uploadTile(i, pixels + tileBytes() * i);
+	}
+	return true;
+}
+
+// 后台线程：逐格解码、缩放并裁圆，每完成一格即发布给 update；最后写缓存
+void TextureAtlas::decodeAll(std::string dir)
+{
+	for (int i = 1; i < SLOTS; ++i) {
+		sf::Image img;
+		decoded[i] = img.loadFromFile(sourcePath(dir, i));
+		if (decoded[i]) blitDisc(&img, tiles.data() + tileBytes() * i, tile);
+		ready[i].store(true, std::memory_order_release);
+	}
+	saveCache(cachePath);
+	workerDone.store(true, std::memory_order_release);
+}
+
+void TextureAtlas::saveCache(const std::string& path) const
+{
+	CacheHeader h;
+	std::memcpy(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+	h.version = CACHE_VERSION;
+	h.tile = tile;
+	h.slots = SLOTS;
+	h.loadedMask = 0;
+	for (int i = 1; i < SLOTS; ++i)
+		if (decoded[i]) h.loadedMask |= 1u << i;
+	h.reserved = 0;
+	std::memcpy(h.stamps, stamps, sizeof(stamps));
+
+	// 先写临时文件再改名，避免中断时留下半个缓存（加载时还会按长度与摘要校验）
+	const std::string tmp = path + ".tmp";
+	{
+		std::ofstream out(tmp, std::ios::binary);
+		if (!out) return;
+		out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+		out.write(reinterpret_cast<const char*>(tiles.data()), static_cast<std::streamsize>(tiles.size()));
+		if (!out) return;
+	}
+	std::error_code ec;
+	std::filesystem::rename(tmp, path, ec);
+}
+
+// 把 src 缩放到格子内 (tile - 2 * PAD) 见方的区域（区域平均；src 为空时画白色），写到 dst 指向的
+// tile x tile RGBA 格子，并按内切圆裁剪：圆外透明，边缘按覆盖率做一像素抗锯齿，与 sf::CircleShape 贴图效果一致
+void TextureAtlas::blitDisc(const sf::Image* src, sf::Uint8* dst, unsigned tile)
+{
+	const unsigned size = tile - 2 * PAD;
+	const float half = size * 0.5f;
+	const unsigned sw = src ? src->getSize().x : 0;
+	const unsigned sh = src ? src->getSize().y : 0;
+	for (unsigned ty = 0; ty < size; ++ty) {
+		for (unsigned tx = 0; tx < size; ++tx) {
+			float dx = tx + 0.5f - half;
+			float dy = ty + 0.5f - half;
+			float coverage = std::min(1.f, std::max(0.f, half - std::sqrt(dx*dx + dy*dy) + 0.5f));
+			if (coverage <= 0.f) continue;
+
+			sf::Color c = sf::Color::White;
+			if (src && sw > 0 && sh > 0) {
+				// 源像素区域 [x0, x1) x [y0, y1)，至少取一个像素（放大时即最近邻）
+				unsigned x0 = tx * sw / size, x1 = std::max(x0 + 1, (tx + 1) * sw / size);
+				unsigned y0 = ty * sh / size, y1 = std::max(y0 + 1, (ty + 1) * sh / size);
+				unsigned r = 0, g = 0, b = 0, a = 0, n = 0;
+				for (unsigned sy = y0; sy < y1 && sy < sh; ++sy) {
+					for (unsigned sx = x0; sx < x1 && sx < sw; ++sx) {
+						sf::Color p = src->getPixel(sx, sy);
+						r += p.r; g += p.g; b += p.b; a += p.a; ++n;
+					}
+				}
+				if (n > 0) c = sf::Color(r / n, g / n, b / n, a / n);
+			}
+			sf::Uint8* px = dst + ((ty + PAD) * tile + tx + PAD) * 4;
+			px[0] = c.r;
+			px[1] = c.g;
+			px[2] = c.b;
+			px[3] = static_cast<sf::Uint8>(c.a * coverage);
+		}
+	}
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <SFML/Graphics.hpp>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 球贴图图集：把 assets/1.png..11.png 缩放到统一大小的格子并裁成圆形（透明角），
+// 拼成一张纹理。所有球都可以作为带纹理坐标的四边形放进同一个顶点数组，一次 draw 画完。
+// 0 号格子是白色圆盘，给没有贴图的等级使用（由顶点颜色着色）。
+//
+// 加载是异步的：beginLoad 立即准备好白色圆盘，窗口可以马上开始渲染（球先显示为纯色圆盘）。
+// 冷启动在后台线程解码 PNG，每解码完一格由 update 上传到纹理；全部完成后把处理好的格子
+// 连同源文件的大小与修改时间写入 dir/atlas.cache。热启动时缓存与源文件一致，
+// 直接映射缓存文件上传，不再解码 PNG。
+class TextureAtlas {
+public:
+	static constexpr int SLOTS = 12;
+
+	TextureAtlas() = default;
+	~TextureAtlas();
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas& operator=(const TextureAtlas&) = delete;
+
+	// 开始从目录 dir 加载图集（需要在有 OpenGL 上下文的线程调用，例如窗口创建之后的主线程）
+	void beginLoad(const std::string& dir);
+	// 每帧在同一线程调用：上传后台已解码完的格子。全部格子就绪后返回 true
+	bool update();
+	bool isComplete() const { return complete; }
+	// 本次是否由缓存加载（热启动）
+	bool loadedFromCache() const { return fromCache; }
+
+	const sf::Texture& getTexture() const { return texture; }
+	// 等级 level 的圆盘在图集中的纹理坐标（像素）
+	sf::FloatRect getRect(int level) const;
+	// 等级 level 的贴图是否已经可用（否则使用白色圆盘 + 颜色）
+	bool hasImage(int level) const { return level > 0 && level < SLOTS && loaded[level]; }
+
+private:
+	size_t tileBytes() const { return static_cast<size_t>(tile) * tile * 4; }
+	void uploadTile(int slot, const sf::Uint8* data);
+	bool loadCache(const std::string& path);
+	void decodeAll(std::string dir);
+	void saveCache(const std::string& path) const;
+	static void blitDisc(const sf::Image* src, sf::Uint8* dst, unsigned tile);
+
+	sf::Texture texture;
+	bool loaded[SLOTS] = {};
+	bool uploaded[SLOTS] = {};
+	bool complete = false;
+	bool fromCache = false;
+	unsigned tile = 256;   // 每个格子的边长
+	unsigned columns = 4;
+	static constexpr unsigned PAD = 2; // 格子内留白，避免平滑采样时串色
+
+	// 后台解码：tiles 按格子连续存放 RGBA（即缓存文件的像素布局），ready[i] 置位后格子 i 只读
+	std::vector<sf::Uint8> tiles;
+	bool decoded[SLOTS] = {};             // 格子 i 是否来自真实贴图（ready 之后有效）
+	std::atomic<bool> ready[SLOTS] = {};
+	std::atomic<bool> workerDone{false};  // 全部格子已解码且缓存已写完
+	std::uint64_t stamps[SLOTS] = {};     // 源文件的大小与修改时间摘要
+	std::string cachePath;
+	std::thread worker;
+};
@@ -0,0 +1,72 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	threadCount = threads < 1 ? 1 : threads;
+	workers.reserve(threadCount - 1);
+	for (unsigned id = 1; id < threadCount; ++id)
+		workers.emplace_back(&ThreadPool::workerLoop, this, id);
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping.store(true);
+		generation.fetch_add(1, std::memory_order_release);
+	}
+	wake.notify_all();
+	for (auto& w : workers) w.join();
+}
+
+// 发布任务：所有工作线程（无论是否分到区间）都要确认一次，
+// 保证下一次发布前没有线程还在读取本次的任务参数
+void ThreadPool::run(size_t count, size_t chunkSize, size_t chunks, Task t, void* ctx)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = t;
+		taskCtx = ctx;
+		taskCount = count;
+		taskChunk = chunkSize;
+		taskChunks = chunks;
+		pending.store(workers.size(), std::memory_order_relaxed);
+		generation.fetch_add(1, std::memory_order_release);
+	}
+	wake.notify_all();
+
+	t(ctx, 0, std::min(count, chunkSize));
+
+	while (pending.load(std::memory_order_acquire) != 0)
+		std::this_thread::yield();
+}
+
+void ThreadPool::workerLoop(unsigned id)
+{
+	// 一步之内会连续发布几十上百个小任务，先短暂自旋等待，空闲较久后再阻塞
+	const int SPIN_LIMIT = 4000;
+	unsigned seen = 0;
+	for (;;) {
+		unsigned g = generation.load(std::memory_order_acquire);
+		for (int i = 0; g == seen && i < SPIN_LIMIT; ++i) {
+			if (i >= 64) std::this_thread::yield();
+			g = generation.load(std::memory_order_acquire);
+		}
+		if (g == seen) {
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return generation.load(std::memory_order_acquire) != seen; });
+			g = generation.load(std::memory_order_acquire);
+		}
+		seen = g;
+		if (stopping.load()) return;
+
+		if (id < taskChunks) {
+			size_t begin = id * taskChunk;
+			size_t end = std::min(taskCount, begin + taskChunk);
+			if (begin < end) task(taskCtx, begin, end);
+		}
+		pending.fetch_sub(1, std::memory_order_release);
+	}
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 固定大小的线程池，专为模拟步内的短小并行循环设计：
+// parallelFor 把 [0, count) 按线程数切成连续区间，调用线程自己处理第 0 段，
+// 其余段交给常驻工作线程，全部完成后才返回（相当于一次屏障）。
+// 切分只取决于 count 与线程数，不依赖调度顺序；各区间互不依赖时结果与单线程一致。
+class ThreadPool {
+public:
+	// threads 为参与计算的总线程数（含调用线程），0 表示取硬件线程数
+	explicit ThreadPool(unsigned threads = 0);
+	~ThreadPool();
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	unsigned size() const { return threadCount; }
+
+	// 对 [0, count) 调用 fn(begin, end)；每段至少 grain 个元素，且段边界按 align 对齐
+	// （便于向量内核整批处理）。元素太少时直接在调用线程上执行。
+	template <class F>
+	void parallelFor(size_t count, size_t grain, size_t align, F&& fn);
+
+private:
+	using Task = void (*)(void* ctx, size_t begin, size_t end);
+	void run(size_t count, size_t chunkSize, size_t chunks, Task task, void* ctx);
+	void workerLoop(unsigned id);
+
+	unsigned threadCount = 1;
+	std::vector<std::thread> workers;
+
+	// 当前任务（由 generation 的递增发布给工作线程）
+	Task task = nullptr;
+	void* taskCtx = nullptr;
+	size_t taskCount = 0;
+	size_t taskChunk = 0;
+	size_t taskChunks = 0;
+	std::atomic<unsigned> generation{0};
+	std::atomic<size_t> pending{0};
+	std::atomic<bool> stopping{false};
+	std::mutex mutex;
+	std::condition_variable wake;
+};
+
+template <class F>
+void ThreadPool::parallelFor(size_t count, size_t grain, size_t align, F&& fn)
+{
+	if (count == 0) return;
+	if (align == 0) align = 1;
+	if (grain < align) grain = align;
+	size_t chunks = count / grain;
+	if (chunks > threadCount) chunks = threadCount;
+	if (chunks <= 1) {
+		fn(size_t(0), count);
+		return;
+	}
+	size_t chunkSize = (count + chunks - 1) / chunks;
+	chunkSize = (chunkSize + align - 1) / align * align;
+	chunks = (count + chunkSize - 1) / chunkSize;
+	using Fn = std::remove_reference_t<F>;
+	Task t = [](void* ctx, size_t begin, size_t end) { (*static_cast<Fn*>(ctx))(begin, end); };
+	run(count, chunkSize, chunks, t, const_cast<void*>(static_cast<const void*>(&fn)));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+
+// 单生产者、单消费者的无锁三缓冲：生产者总有一个可写的缓冲，消费者总能拿到最近一次完整发布的缓冲，
+// 双方都不等待对方。三个缓冲分别归生产者（back）、消费者（front）所有，第三个（middle）放在原子变量里交接：
+// publish 把写好的 back 与 middle 交换并标记为新，acquire 在有新数据时把 front 与 middle 交换。
+// 消费者来不及读取的中间版本会被下一次发布直接覆盖（只关心最新状态）。
+template <class T>
+class TripleBuffer {
+public:
+	// 三个缓冲（用于在生产者与消费者开始工作之前统一预留容量）
+	T& slot(int i) { return slots[i]; }
+
+	// 生产者：当前可写的缓冲
+	T& writeBuffer() { return slots[back]; }
+	// 生产者：发布刚写好的缓冲，之后 writeBuffer 返回另一个缓冲
+	void publish()
+	{
+		back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & INDEX;
+	}
+
+	// 消费者：有新发布时切换到最新的缓冲并返回 true；没有时保留当前缓冲
+	bool acquire()
+	{
+		if (!(middle.load(std::memory_order_relaxed) & FRESH)) return false;
+		front = middle.exchange(front, std::memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	// 消费者：当前持有的缓冲（在下一次成功的 acquire 之前保持不变）
+	const T& readBuffer() const { return slots[front]; }
+
+private:
+	static constexpr unsigned INDEX = 3;
+	static constexpr unsigned FRESH = 4;
+
+	T slots[3];
+	// 生产者与消费者各自的下标分处不同的缓存行，互不干扰
+	alignas(64) std::atomic<unsigned> middle{1};
+	alignas(64) unsigned back = 0;
+	alignas(64) unsigned front = 2;
+};
@@ -0,0 +1,19 @@
+#pragma once
+
+// 无依赖的二维向量，供无窗口（headless）的物理核心使用；渲染层再转换为 sf::Vector2f
+struct Vec2 {
+	float x = 0.f;
+	float y = 0.f;
+
+	Vec2() = default;
+	Vec2(float x_, float y_) : x(x_), y(y_) {}
+
+	Vec2& operator+=(const Vec2& o) { x += o.x; y += o.y; return *this; }
+	Vec2& operator-=(const Vec2& o) { x -= o.x; y -= o.y; return *this; }
+};
+
+inline Vec2 operator+(Vec2 a, const Vec2& b) { return a += b; }
+inline Vec2 operator-(Vec2 a, const Vec2& b) { return a -= b; }
+inline Vec2 operator-(const Vec2& a) { return Vec2(-a.x, -a.y); }
+inline Vec2 operator*(const Vec2& a, float s) { return Vec2(a.x * s, a.y * s); }
+inline Vec2 operator*(float s, const Vec2& a) { return Vec2(a.x * s, a.y * s); }
@@ -0,0 +1,133 @@
+#include "WorkStealingPool.h"
+#include <algorithm>
+
+namespace {
+
+std::uint64_t pack(std::uint32_t lo, std::uint32_t hi)
+{
+	return (static_cast<std::uint64_t>(hi) << 32) | lo;
+}
+
+std::uint32_t spanLo(std::uint64_t v) { return static_cast<std::uint32_t>(v); }
+std::uint32_t spanHi(std::uint64_t v) { return static_cast<std::uint32_t>(v >> 32); }
+
+} // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned threads)
+{
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	threadCount = threads < 1 ? 1 : threads;
+	queues.reset(new Queue[threadCount]);
+	workers.reserve(threadCount - 1);
+	for (unsigned id = 1; id < threadCount; ++id)
+		workers.emplace_back(&WorkStealingPool::workerLoop, this, id);
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping.store(true);
+		generation.fetch_add(1, std::memory_order_release);
+	}
+	wake.notify_all();
+	for (auto& w : workers) w.join();
+}
+
+// 发布一批任务：按线程数切成连续区间，调用线程处理第 0 个队列；
+// 所有任务完成且所有工作线程都确认过本次发布后返回（下一次发布前没有线程还在读取任务参数）
+void WorkStealingPool::dispatch(size_t count, Task t, void* ctx)
+{
+	const size_t chunk = (count + threadCount - 1) / threadCount;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		task = t;
+		taskCtx = ctx;
+		for (unsigned q = 0; q < threadCount; ++q) {
+			size_t lo = std::min(count, q * chunk);
+			size_t hi = std::min(count, lo + chunk);
+			queues[q].span.store(pack(static_cast<std::uint32_t>(lo), static_cast<std::uint32_t>(hi)), std::memory_order_relaxed);
+		}
+		remaining.store(count, std::memory_order_relaxed);
+		pending.store(workers.size(), std::memory_order_relaxed);
+		generation.fetch_add(1, std::memory_order_release);
+	}
+	wake.notify_all();
+
+	work(0);
+
+	while (remaining.load(std::memory_order_acquire) != 0 || pending.load(std::memory_order_acquire) != 0)
+		std::this_thread::yield();
+}
+
+// 从自己区间的头部取一个任务
+bool WorkStealingPool::popLocal(unsigned id, size_t& index)
+{
+	std::atomic<std::uint64_t>& span = queues[id].span;
+	std::uint64_t v = span.load(std::memory_order_acquire);
+	while (spanLo(v) < spanHi(v)) {
+		if (span.compare_exchange_weak(v, pack(spanLo(v) + 1, spanHi(v)), std::memory_order_acq_rel)) {
+			index = spanLo(v);
+			return true;
+		}
+	}
+	return false;
+}
+
+// 自己的区间已空：从其他线程区间的尾部窃取一半，第一个任务立即执行，其余放进自己的区间。
+// 只有区间为空的拥有者会整体改写自己的区间，而空区间不会被窃取，因此这里直接 store 即可
+bool WorkStealingPool::steal(unsigned id, size_t& index)
+{
+	for (unsigned k = 1; k < threadCount; ++k) {
+		std::atomic<std::uint64_t>& victim = queues[(id + k) % threadCount].span;
+		std::uint64_t v = victim.load(std::memory_order_acquire);
+		while (spanLo(v) < spanHi(v)) {
+			const std::uint32_t lo = spanLo(v), hi = spanHi(v);
+			const std::uint32_t take = (hi - lo + 1) / 2;
+			if (victim.compare_exchange_weak(v, pack(lo, hi - take), std::memory_order_acq_rel)) {
+				index = hi - take;
+				queues[id].span.store(pack(hi - take + 1, hi), std::memory_order_release);
+				steals.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+void WorkStealingPool::work(unsigned id)
+{
+	size_t index;
+	for (;;) {
+		if (!popLocal(id, index) && !steal(id, index)) {
+			// 所有区间都已取空：剩下的任务正由其他线程执行
+			return;
+		}
+		task(taskCtx, index, id);
+		remaining.fetch_sub(1, std::memory_order_acq_rel);
+	}
+}
+
+void WorkStealingPool::workerLoop(unsigned id)
+{
+	// 连续的批次之间通常间隔很短，先短暂自旋等待，空闲较久后再阻塞
+	const int SPIN_LIMIT = 4000;
+	unsigned seen = 0;
+	for (;;) {
+		unsigned g = generation.load(std::memory_order_acquire);
+		for (int i = 0; g == seen && i < SPIN_LIMIT; ++i) {
+			if (i >= 64) std::this_thread::yield();
+			g = generation.load(std::memory_order_acquire);
+		}
+		if (g == seen) {
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&] { return generation.load(std::memory_order_acquire) != seen; });
+			g = generation.load(std::memory_order_acquire);
+		}
+		seen = g;
+		if (stopping.load()) return;
+
+		work(id);
+		pending.fetch_sub(1, std::memory_order_release);
+	}
+}
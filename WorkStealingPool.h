@@ -0,0 +1,74 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// 窃取式线程池：一批互相独立、耗时差异很大的任务（例如各局游戏的一段推进）。
+// 任务编号 [0, count) 先按线程数切成连续区间放进各线程的队列，线程从自己区间的头部逐个取任务，
+// 自己的区间取空后从其他线程区间的尾部一次窃取一半。每个队列只是一个打包成 64 位的 [lo, hi) 原子区间，
+// 取任务与窃取都是一次 CAS，不加锁也不分配内存。
+// 与 ThreadPool 一样，调用线程作为第 0 号线程参与执行，全部任务完成后 run 才返回。
+class WorkStealingPool {
+public:
+	// threads 为参与计算的总线程数（含调用线程），0 表示取硬件线程数
+	explicit WorkStealingPool(unsigned threads = 0);
+	~WorkStealingPool();
+	WorkStealingPool(const WorkStealingPool&) = delete;
+	WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+	unsigned size() const { return threadCount; }
+
+	// 对每个 i ∈ [0, count) 调用一次 fn(i, thread)，thread 为执行该任务的线程编号（0..size()-1）
+	template <class F>
+	void run(size_t count, F&& fn);
+
+	// 累计窃取成功次数（诊断负载均衡用）
+	std::uint64_t getSteals() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+	using Task = void (*)(void* ctx, size_t index, unsigned thread);
+	void dispatch(size_t count, Task task, void* ctx);
+	void work(unsigned id);
+	bool popLocal(unsigned id, size_t& index);
+	bool steal(unsigned id, size_t& index);
+	void workerLoop(unsigned id);
+
+	// 每个线程一个区间，独占缓存行，避免相邻队列的 CAS 互相干扰
+	struct alignas(64) Queue {
+		std::atomic<std::uint64_t> span{0}; // 高 32 位 hi，低 32 位 lo
+	};
+
+	unsigned threadCount = 1;
+	std::unique_ptr<Queue[]> queues;
+	std::vector<std::thread> workers;
+
+	Task task = nullptr;
+	void* taskCtx = nullptr;
+	std::atomic<size_t> remaining{0};   // 尚未完成的任务数
+	std::atomic<unsigned> generation{0};
+	std::atomic<size_t> pending{0};     // 尚未确认本次发布的工作线程数
+	std::atomic<bool> stopping{false};
+	std::atomic<std::uint64_t> steals{0};
+	std::mutex mutex;
+	std::condition_variable wake;
+};
+
+template <class F>
+void WorkStealingPool::run(size_t count, F&& fn)
+{
+	if (count == 0) return;
+	if (threadCount == 1 || count == 1) {
+		for (size_t i = 0; i < count; ++i) fn(i, 0u);
+		return;
+	}
+	using Fn = std::remove_reference_t<F>;
+	Task t = [](void* ctx, size_t index, unsigned thread) { (*static_cast<Fn*>(ctx))(index, thread); };
+	dispatch(count, t, const_cast<void*>(static_cast<const void*>(&fn)));
+}
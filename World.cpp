@@ -0,0 +1,1050 @@
+#include "World.h"
+#include <cmath>
+#include <algorithm>
+
+// 与 PhysicsKernels.cpp 相同：禁止融合乘加，结果不随 -march 变化，记录在不同构建之间可以重放
+#if defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+World::World(float width_, float height_, size_t maxBalls)
+    : World(Rules::CLASSIC, width_, height_, maxBalls)
+{
+}
+
+World::World(const RuleSet& rules_)
+    : World(rules_, rules_.width, rules_.floorY, rules_.maxBalls)
+{
+}
+
+World::World(const RuleSet& rules_, float width_, float height_, size_t maxBalls)
+    : rules(&rules_), width(width_), height(height_),
+      kernels(&PhysicsKernels::best(rules_)), MAX_BALLS(maxBalls), lifelineY(rules_.lifelineY)
+{
+    // 预留容量，生成/合并时不再触发重新分配
+    balls.reserve(MAX_BALLS);
+    reserveScratch();
+    // 选择初始的下一个生成等级（用于 UI 预览）
+    pickNextSpawnLevel();
+}
+
+// 按球数上限预留每步的临时缓冲区，稳定运行时模拟步内不再有堆分配
+void World::reserveScratch()
+{
+    const size_t n = MAX_BALLS;
+    grid.configure(gridCellSize(), width, height);
+    grid.reserve(n);
+    contacts.reserve(n * PAIRS_PER_BALL);
+    candidates.reserve(n * PAIRS_PER_BALL);
+    upStart.reserve(n + 1);
+    upList.reserve(2 * n * PAIRS_PER_BALL);
+    upFill.reserve(std::max<size_t>(n, MAX_SOLVER_COLORS + 2));
+    batchStart.reserve(MAX_SOLVER_COLORS + 2);
+    supported.reserve(n);
+    solverA.reserve(n * PAIRS_PER_BALL);
+    solverB.reserve(n * PAIRS_PER_BALL);
+    pairColor.reserve(n * PAIRS_PER_BALL);
+    usedColors.reserve(n);
+    spawnRequests.reserve(n + 1);
+    fastBalls.reserve(n);
+    awake.reserve(n);
+    islandParent.reserve(n);
+    islandReady.reserve(n);
+    islandId.reserve(n);
+    pendingWake.reserve(64);
+    touchedIslands.reserve(64);
+    size_t columns = static_cast<size_t>(std::ceil(width / SKYLINE_COLUMN));
+    skyline.assign(std::max<size_t>(columns, 1), height);
+    sleepSkyline.assign(skyline.size(), height);
+    stackTop = sleepTop = height;
+}
+
+// 宽相格子边长：最大球直径再留出支撑判定的容差
+float World::gridCellSize() const
+{
+    return 2.f * rules->radius[rules->maxLevel] + 4.f;
+}
+
+// 随机选择下一次要生成的球的等级（遵循已有的 1..3 随机并考虑第3级解锁）
+void World::pickNextSpawnLevel()
+{
+    // 默认行为：随机 1..3，若 3 未解锁则退为 1/2
+    int pick = rng.below(3) + 1; // 1..3
+    if (pick == 3 && score < rules->level3UnlockScore) {
+        pick = rng.below(2) + 1; // 1 or 2
+    }
+    nextSpawnLevel = pick;
+}
+
+// 生成新球
+BallStore::Handle World::spawnBall(float x, float y, int level)
+{
+    if (level < 1) level = 1;
+    if (level > rules->maxLevel) level = rules->maxLevel;
+    if (balls.size() >= MAX_BALLS) return BallStore::Handle(); // 限制球的总数
+
+    // 保证在容器内部横坐标
+    float winW = width;
+    float minX = leftMargin + 8.f;
+    float maxX = winW - rightMargin - 8.f;
+    if (x < minX) x = minX;
+    if (x > maxX) x = maxX;
+
+    // 先根据等级获取半径
+    float r = rules->radius[level];
+
+    // 候选位置是否与已有球重叠过多：用宽相网格只检查候选点附近格子里的球。
+    // 判定距离 (r + rb) * 0.82 小于格子边长，因此相邻 3x3 格子已覆盖所有可能的冲突
+    auto posOf = [this](size_t k) { return Vec2(balls.x[k], balls.y[k]); };
+    auto deadOf = [this](size_t k) { return balls.isDead(k); };
+    grid.configure(gridCellSize(), width, height);
+    grid.build(balls.size(), posOf, deadOf);
+    auto blocked = [&](float px, float py) {
+        return grid.any(px, py, [&](int b) {
+            float dx = px - balls.x[b];
+            float dy = py - balls.y[b];
+            float dist2 = dx*dx + dy*dy;
+            float minDist = (r + balls.radius[b]) * 0.82f; // 允许略紧密
+            return dist2 < minDist * minDist;
+        });
+    };
+
+    // 尝试不同横向偏移（左右交替）寻找不重叠位置
+    float chosenX = x;
+    float chosenY = y;
+    bool placed = false;
+    const int maxOffsetSteps = 24;
+    for (int step = 0; step < maxOffsetSteps && !placed; ++step) {
+        int k = step/2;
+        int side = (step % 2 == 0) ? 1 : -1;
+        float offset = (k + 0.0f) * (r * 0.85f + 6.f) * side;
+        float nx = x + offset;
+        if (nx < minX + r) nx = minX + r;
+        if (nx > maxX - r) nx = maxX - r;
+
+        if (!blocked(nx, y)) { chosenX = nx; placed = true; break; }
+    }
+
+    // 如果横向没有合适位置，尝试向上抬高更多步以便堆叠
+    if (!placed) {
+        const int upAttempts = 30;
+        for (int u = 1; u <= upAttempts && !placed; ++u) {
+            float ny = y - u * (r * 0.9f + 4.f);
+            if (ny < r + 8.f) break;
+            for (int step = 0; step < maxOffsetSteps && !placed; ++step) {
+                int k = step/2;
+                int side = (step % 2 == 0) ? 1 : -1;
+                float offset = (k + 0.0f) * (r * 0.85f + 6.f) * side;
+                float nx = x + offset;
+                if (nx < minX + r) nx = minX + r;
+                if (nx > maxX - r) nx = maxX - r;
+                if (!blocked(nx, ny)) { chosenX = nx; chosenY = ny; placed = true; break; }
+            }
+        }
+    }
+
+    if (!placed) {
+        // 如果确实放不下，则尝试在窗口顶部少许位置生成（让它自然落下）
+        float topY = r + 12.f;
+        chosenX = std::min(std::max(x, minX + r), maxX - r);
+        chosenY = topY;
+    }
+
+    size_t idx = balls.add(chosenX, chosenY, level, *rules);
+    // 给一点初速度避免完全垂直停滞
+    float vy = -90.f + (rng.below(80) - 40);
+    float vx = (rng.below(80) - 40) * 0.4f;
+    balls.vx[idx] = vx;
+    balls.vy[idx] = vy;
+    // 生命线相关字段已由 add 初始化（prev = 当前位置，计时为 0），避免 spawn 时被立即判死
+    balls.setFlag(idx, BallStore::SPAWNED_ABOVE_LINE, chosenY - balls.radius[idx] <= lifelineY);
+    return balls.handle(idx);
+}
+
+// 玩家点击：使用已经预选的 nextSpawnLevel 来生成球，然后再选一个新的 nextSpawnLevel
+BallStore::Handle World::dropNext(float x, float y)
+{
+    if (gameOver) return BallStore::Handle();
+    int pick = nextSpawnLevel;
+    // 作为保险，如果 pick 超过最高等级或小于 1，则修正
+    if (pick < 1) pick = 1;
+    if (pick > rules->maxLevel) pick = rules->maxLevel;
+    BallStore::Handle h = spawnBall(x, y, pick);
+    // 生成后立刻选择下一个预览
+    pickNextSpawnLevel();
+    return h;
+}
+
+BallStore::Handle World::addBall(float x, float y, int level, float vx, float vy)
+{
+    if (balls.size() >= MAX_BALLS) return BallStore::Handle();
+    level = std::max(0, std::min(level, rules->maxLevel));
+    size_t idx = balls.add(x, y, level, *rules);
+    balls.vx[idx] = vx;
+    balls.vy[idx] = vy;
+    balls.setFlag(idx, BallStore::SPAWNED_ABOVE_LINE, y - balls.radius[idx] <= lifelineY);
+    return balls.handle(idx);
+}
+
+// 计时辅助：把 since 以来的耗时累加到 acc（并写入挂接的剖析器）后返回当前时间；关闭计时时直接返回 0
+std::uint64_t World::lap(std::uint64_t& acc, std::uint64_t since, Profiler::Phase phase)
+{
+    if (!timing()) return 0;
+    std::uint64_t now = Profiler::now();
+    acc += now - since;
+    if (profiler) profiler->record(phase, since, now);
+    return now;
+}
+
+// 推进一个固定步
+void World::step(float dt)
+{
+    // 记录本步开始时的位置，供渲染在两步之间插值
+    balls.startX = balls.x;
+    balls.startY = balls.y;
+    stepStats = StepStats();
+
+    const float h = dt / static_cast<float>(substeps);
+    for (int s = 0; s < substeps; ++s)
+        substep(h);
+    ++stepCount;
+}
+
+// 子步：完整的一次积分与碰撞处理
+void World::substep(float dt)
+{
+    std::uint64_t t = timing() ? Profiler::now() : 0;
+    buildAwakeList();
+    if (!gameOver) {
+        // 只积分醒着的球：按连续下标段调用内核（全部醒着时就是整段 [0, n)）
+        size_t k = 0;
+        while (k < awake.size()) {
+            size_t begin = static_cast<size_t>(awake[k]);
+            size_t end = begin + 1;
+            while (++k < awake.size() && static_cast<size_t>(awake[k]) == end) ++end;
+            kernels->integrate(balls, begin, end, dt);
+        }
+        if (ccdEnabled) sweepFastBalls();
+    }
+    lap(phaseTimes.integrate, t, Profiler::Integrate);
+
+    // 先处理碰撞（碰撞可能会产生新球）
+    checkCollisions();
+    t = timing() ? Profiler::now() : 0;
+
+    // 休眠判定需要本步的球对表，必须在移除死亡球（下标变化）之前
+    updateSleep(dt);
+
+    // 生命线判定与顶部轮廓都只需看醒着的球，同样要在移除死亡球之前（awake 下标仍有效）
+    checkLifeline(dt);
+    updateSkyline();
+
+    // 移除已经死亡的球
+    balls.removeDead();
+
+    // 如果所有球都在地面并速度接近 0，则解锁生成（休眠的球视为静止）
+    bool anyMoving = false;
+    for (size_t b = 0; b < balls.size(); ++b) {
+        if (balls.isSleeping(b)) continue;
+        if (!balls.isOnGround(b)) { anyMoving = true; break; }
+        // 速度接近 0
+        if (std::abs(balls.vy[b]) > 1.f) { anyMoving = true; break; }
+    }
+    if (!anyMoving) spawnLocked = false;
+    lap(phaseTimes.other, t, Profiler::Other);
+}
+
+// 合并：窄相的接触表就是接触事件。等级相同且都被支撑的接触对合成为高一级的球，
+// 合成球先作为生成请求放进 spawns（两个原球标记为死亡）。
+// 开启连锁合并时 spawns 同时是事件队列：按顺序取出每个新的生成请求，
+// 若它与周围同级的球（或同级的其他生成请求）接触，就在本子步内继续合成，并把更高一级的请求追加到队尾
+void World::resolveMerges()
+{
+    std::vector<SpawnReq>& spawns = spawnRequests;
+    // 优先合并：遍历所有接触对，如果接触且等级相同则立即合并
+    // 但仅当两球都被“支撑”（supported）时才允许合并——即接触地面或通过一系列接触链条接触地面
+    for (const Contact& c : contacts) {
+        size_t i = c.a;
+        size_t j = c.b;
+        if (balls.isDead(i) || balls.isDead(j)) continue;
+        if (balls.level[i] != balls.level[j]) continue;
+        // 只允许在“被支撑”的情况下合并
+        if (!isSupported(i) || !isSupported(j)) continue;
+        float dx = balls.x[i] - balls.x[j];
+        float dy = balls.y[i] - balls.y[j];
+        float rsum = balls.radius[i] + balls.radius[j];
+        if (dx*dx + dy*dy > rsum * rsum) continue;
+        // 仅当当前等级小于最大等级时才合成为更高等级
+        if (balls.level[i] >= rules->maxLevel) continue;
+        balls.setFlag(j, BallStore::DEAD, true);
+        balls.setFlag(i, BallStore::DEAD, true);
+        mergeInto(spawns, balls.x[i], balls.y[i], balls.x[j], balls.y[j], balls.level[i]);
+    }
+    if (!mergeCascades) return;
+
+    // 连锁：合成球由两个被支撑的球合成，本身视为被支撑；与之合并的原球同样要求被支撑。
+    // 网格格子边长不小于任意两球半径之和，相邻 3x3 格子已覆盖所有可能的接触
+    for (size_t q = 0; q < spawns.size(); ++q) {
+        const SpawnReq s = spawns[q];
+        if (s.merged || s.level >= rules->maxLevel) continue;
+        const float r = rules->radius[s.level];
+        int partner = -1;
+        grid.any(s.x, s.y, [&](int k) {
+            if (balls.isDead(k) || balls.level[k] != s.level || !isSupported(k)) return false;
+            float dx = s.x - balls.x[k];
+            float dy = s.y - balls.y[k];
+            float rsum = r + balls.radius[k];
+            if (dx*dx + dy*dy > rsum * rsum) return false;
+            partner = k;
+            return true;
+        });
+        if (partner >= 0) {
+            spawns[q].merged = true;
+            balls.setFlag(partner, BallStore::DEAD, true);
+            if (balls.isSleeping(partner)) queueWake(balls.island[partner]);
+            mergeInto(spawns, s.x, s.y, balls.x[partner], balls.y[partner], s.level);
+            continue;
+        }
+        // 同一子步内相邻的两处合并可能得到相互接触的同级合成球
+        for (size_t p = 0; p < q; ++p) {
+            const SpawnReq& o = spawns[p];
+            if (o.merged || o.level != s.level) continue;
+            float dx = s.x - o.x;
+            float dy = s.y - o.y;
+            if (dx*dx + dy*dy > 4.f * r * r) continue;
+            spawns[q].merged = true;
+            spawns[p].merged = true;
+            mergeInto(spawns, s.x, s.y, o.x, o.y, s.level);
+            break;
+        }
+    }
+}
+
+// 两个 level 级的球（或生成请求）在中点合成为高一级的生成请求并计分
+void World::mergeInto(std::vector<SpawnReq>& spawns, float x1, float y1, float x2, float y2, int level)
+{
+    int newLevel = level + 1;
+    Vec2 mid((x1 + x2) / 2.f, (y1 + y2) / 2.f);
+    // 生成合成球时不要给予强烈向上速度，设置为不动以避免跳起
+    spawns.push_back({mid.x, mid.y - 4.f, newLevel, Vec2(0.f, 0.f)});
+    score += rules->mergeScore[newLevel];
+    ++stepStats.merges;
+}
+
+// 连续碰撞：找出本子步位移过大的球，按下标顺序逐个沿位移扫掠
+void World::sweepFastBalls()
+{
+    fastBalls.clear();
+    for (int k : awake) {
+        float dx = balls.x[k] - balls.prevX[k];
+        float dy = balls.y[k] - balls.prevY[k];
+        float limit = CCD_TRAVEL * balls.radius[k];
+        if (dx*dx + dy*dy > limit * limit) fastBalls.push_back(k);
+    }
+    if (fastBalls.empty()) return;
+    sweptCount += fastBalls.size();
+
+    for (int k : fastBalls) balls.setFlag(k, BallStore::SWEPT, true);
+    grid.configure(gridCellSize(), width, height);
+    grid.build(balls.size(), [this](size_t k) { return Vec2(balls.x[k], balls.y[k]); },
+               [this](size_t k) { return balls.isDead(k); });
+    // 慢球本子步的位移不超过 CCD_TRAVEL 倍半径：按最大半径放宽查询范围即可覆盖其整段轨迹
+    const float maxR = rules->radius[rules->maxLevel];
+    const float reach = maxR * (1.f + CCD_TRAVEL);
+    for (int k : fastBalls) sweepBall(k, reach);
+    for (int k : fastBalls) balls.setFlag(k, BallStore::SWEPT, false);
+    wakeQueuedIslands();
+}
+
+// 扫掠圆：求球 i 从子步起点 prev 到当前位置的线段上与墙、其他球的最早接触时刻 toi ∈ [0, 1)。
+// 其他醒着的球按其本子步的位移做相对运动（快球之间也不会互相穿过），休眠的球视为静止。
+// 起点已经接触的球对交给分离求解。命中后把球放回接触位置，并按质量比例去掉沿法线的接近速度
+void World::sweepBall(int i, float reach)
+{
+    const float r = balls.radius[i];
+    const float sx = balls.prevX[i], sy = balls.prevY[i];
+    const float dx = balls.x[i] - sx, dy = balls.y[i] - sy;
+    float toi = 1.f;
+    int partner = -1;
+
+    // 左右墙（与墙面约束使用相同的边界）
+    const float left = leftMargin + r;
+    const float right = width - rightMargin - r;
+    if (dx < 0.f && sx >= left && sx + dx < left) toi = std::min(toi, (left - sx) / dx);
+    if (dx > 0.f && sx <= right && sx + dx > right) toi = std::min(toi, (right - sx) / dx);
+
+    auto test = [&](int j) {
+        if (j == i || balls.isDead(j)) return;
+        float jdx = 0.f, jdy = 0.f;
+        if (!balls.isSleeping(j)) {
+            jdx = balls.x[j] - balls.prevX[j];
+            jdy = balls.y[j] - balls.prevY[j];
+        }
+        const float px = sx - (balls.x[j] - jdx);
+        const float py = sy - (balls.y[j] - jdy);
+        const float ux = dx - jdx, uy = dy - jdy;
+        const float rsum = r + balls.radius[j];
+        const float c = px*px + py*py - rsum * rsum;
+        if (c <= 0.f) return;          // 起点已接触
+        const float b = px*ux + py*uy;
+        if (b >= 0.f) return;          // 相互远离
+        const float a = ux*ux + uy*uy;
+        const float disc = b*b - a*c;
+        if (disc < 0.f) return;        // 擦肩而过
+        const float t = (-b - std::sqrt(disc)) / a;
+        if (t < toi) { toi = t; partner = j; }
+    };
+    grid.queryRect(std::min(sx, sx + dx) - r - reach, std::min(sy, sy + dy) - r - reach,
+                   std::max(sx, sx + dx) + r + reach, std::max(sy, sy + dy) + r + reach,
+                   [&](int j) { if (!(balls.flags[j] & BallStore::SWEPT)) test(j); });
+    for (int j : fastBalls) test(j);
+    if (toi >= 1.f) return;
+    toi = std::max(toi, 0.f);
+    ++sweepHits;
+
+    balls.x[i] = sx + dx * toi;
+    balls.y[i] = sy + dy * toi;
+    if (partner < 0) {
+        balls.vx[i] = -balls.vx[i] * 0.2f; // 与墙面约束相同的小反弹
+        return;
+    }
+
+    const size_t j = static_cast<size_t>(partner);
+    const bool sleepingJ = balls.isSleeping(j);
+    float jx = balls.x[j], jy = balls.y[j];
+    if (!sleepingJ) {
+        jx = balls.prevX[j] + (balls.x[j] - balls.prevX[j]) * toi;
+        jy = balls.prevY[j] + (balls.y[j] - balls.prevY[j]) * toi;
+        // 快球之间：对方同样停在接触时刻的位置
+        if (balls.flags[j] & BallStore::SWEPT) { balls.x[j] = jx; balls.y[j] = jy; }
+    }
+    float nx = balls.x[i] - jx, ny = balls.y[i] - jy;
+    const float len = std::sqrt(nx*nx + ny*ny);
+    if (len <= 0.0001f) return;
+    nx /= len; ny /= len;
+    float vjx = sleepingJ ? 0.f : balls.vx[j], vjy = sleepingJ ? 0.f : balls.vy[j];
+    const float vn = (balls.vx[i] - vjx) * nx + (balls.vy[i] - vjy) * ny;
+    if (vn >= 0.f) return;
+    if (sleepingJ) {
+        // 休眠的球视为固定，同时唤醒其岛
+        balls.vx[i] -= nx * vn; balls.vy[i] -= ny * vn;
+        queueWake(balls.island[j]);
+        return;
+    }
+    const float mi = balls.mass[i], mj = balls.mass[j], total = mi + mj;
+    balls.vx[i] -= nx * vn * (mj / total); balls.vy[i] -= ny * vn * (mj / total);
+    balls.vx[j] += nx * vn * (mi / total); balls.vy[j] += ny * vn * (mi / total);
+}
+
+// 简单碰撞检测：如果两个球重叠，则将其中一个标记为死亡（这是占位逻辑，便于编译和演示）
+void World::checkCollisions()
+{
+    // 为避免在迭代中直接修改 balls，先收集要生成的新球请求（缓冲区跨步复用）
+    std::vector<SpawnReq>& spawns = spawnRequests;
+    spawns.clear();
+
+    // 所有球都在休眠：没有会变化的球对，本子步无需任何碰撞处理
+    if (awake.empty()) {
+        contacts.clear();
+        candidates.clear();
+        stepStats.maxOverlap = stepStats.sumOverlap = 0.f;
+        return;
+    }
+
+    std::uint64_t t = timing() ? Profiler::now() : 0;
+
+    // 宽相：合并与分离都只需查询相邻格子
+    float winW = width;
+    grid.configure(gridCellSize(), winW, height);
+    auto posOf = [this](size_t k) { return Vec2(balls.x[k], balls.y[k]); };
+    auto deadOf = [this](size_t k) { return balls.isDead(k); };
+    grid.build(balls.size(), posOf, deadOf);
+
+    // 快速运动的球碰到休眠的球时唤醒对方所在的岛
+    wakeTouchedIslands();
+
+    // 每步只建一次接触表与支撑图，合并判定中的 isSupported 变为 O(1) 查表
+    buildSupportGraph();
+    stepStats.contacts += static_cast<std::uint32_t>(contacts.size());
+    t = lap(phaseTimes.support, t, Profiler::Support);
+
+    resolveMerges();
+
+    // 被合并移除的球若支撑着休眠的球（或自身在休眠），唤醒相关的岛
+    for (const Contact& c : contacts) {
+        bool deadA = balls.isDead(c.a), deadB = balls.isDead(c.b);
+        if (!deadA && !deadB) continue;
+        if (balls.isSleeping(c.a)) queueWake(balls.island[c.a]);
+        if (balls.isSleeping(c.b)) queueWake(balls.island[c.b]);
+    }
+    wakeQueuedIslands();
+
+    // 将生成请求转换为实际球（受 MAX_BALLS 限制）
+    for (auto& r : spawns) {
+        if (r.merged) continue; // 已在连锁中继续合成
+        if (balls.size() >= MAX_BALLS) break;
+        // 如果生成的是胜利等级，则标记为胜利状态
+        if (r.level >= rules->maxLevel) {
+            gameWin = true;
+            gameOver = false;
+            // 仍然生成这个球以便视觉显示
+        }
+        size_t idx = balls.add(r.x, r.y, r.level, *rules);
+        balls.vx[idx] = r.vel.x;
+        balls.vy[idx] = r.vel.y;
+        // 初始化生命线相关字段
+        balls.setFlag(idx, BallStore::SPAWNED_ABOVE_LINE, r.y - balls.radius[idx] <= lifelineY);
+    }
+    t = lap(phaseTimes.merge, t, Profiler::Merge);
+
+    // 更严格的迭代碰撞分离：多次通过以确保没有明显侵入
+    // 候选球对每步生成一次并按颜色分批；同批球对互不干扰，交给向量内核整批处理
+    grid.build(balls.size(), posOf, deadOf);
+    buildAwakeList(); // 去掉合并掉的球，加入新生成的球
+    buildSolverBatches();
+    // 批次太小时线程同步的开销大于收益，由调用线程直接求解
+    const size_t PARALLEL_GRAIN = 256;
+    for (int pass = 0; pass < separationPasses; ++pass) {
+        for (size_t c = 0; c + 1 < batchStart.size(); ++c) {
+            size_t begin = batchStart[c];
+            size_t count = batchStart[c + 1] - begin;
+            if (count == 0) continue;
+            // 最后一个批次收容颜色溢出的球对（可能共享球），只能单线程按顺序标量求解
+            if (c + 2 == batchStart.size()) {
+                PhysicsKernels::get(SimdLevel::Scalar).solve(balls, solverA.data() + begin, solverB.data() + begin, count);
+                continue;
+            }
+            // 同色球对互不共享球，切成连续区间交给各线程，与整批顺序求解的结果相同
+            const int* a = solverA.data() + begin;
+            const int* b = solverB.data() + begin;
+            auto solveRange = [&](size_t lo, size_t hi) { kernels->solve(balls, a + lo, b + lo, hi - lo); };
+            if (pool) pool->parallelFor(count, PARALLEL_GRAIN, 8, solveRange);
+            else solveRange(0, count);
+        }
+    }
+    if (overlapStats) measureOverlap();
+
+    t = lap(phaseTimes.separation, t, Profiler::Separation);
+
+    // 墙面约束（左右），并减少水平速度（小的反弹）；休眠的球不会越界
+    for (int b : awake) {
+        float r = balls.radius[b];
+        if (balls.x[b] - r < leftMargin) {
+            balls.x[b] = leftMargin + r;
+            balls.vx[b] = -balls.vx[b] * 0.2f; // 小反弹
+        } else if (balls.x[b] + r > winW - rightMargin) {
+            balls.x[b] = winW - rightMargin - r;
+            balls.vx[b] = -balls.vx[b] * 0.2f;
+        }
+    }
+    lap(phaseTimes.walls, t, Profiler::Walls);
+}
+
+// 分离求解之后候选球对的剩余穿透（只读，不影响模拟）
+void World::measureOverlap()
+{
+    float maxOverlap = 0.f, sumOverlap = 0.f;
+    for (size_t k = 0; k < solverA.size(); ++k) {
+        int a = solverA[k], b = solverB[k];
+        float dx = balls.x[a] - balls.x[b];
+        float dy = balls.y[a] - balls.y[b];
+        float rsum = balls.radius[a] + balls.radius[b];
+        float d2 = dx*dx + dy*dy;
+        if (d2 >= rsum * rsum) continue;
+        float overlap = rsum - std::sqrt(d2);
+        maxOverlap = std::max(maxOverlap, overlap);
+        sumOverlap += overlap;
+    }
+    stepStats.maxOverlap = maxOverlap;
+    stepStats.sumOverlap = sumOverlap;
+}
+
+void World::setThreads(unsigned n)
+{
+    if (n == 0) n = std::thread::hardware_concurrency();
+    if (n <= 1) pool.reset();
+    else if (!pool || pool->size() != n) pool.reset(new ThreadPool(n));
+    // 每段扫描的结果缓冲区同样预先留足
+    pairScratch.resize(pool ? n : 0);
+    for (auto& part : pairScratch) part.reserve((MAX_BALLS / n + 1) * PAIRS_PER_BALL);
+}
+
+void World::setSeed(std::uint64_t s)
+{
+    seed = s;
+    rng.reseed(s);
+    pickNextSpawnLevel();
+}
+
+// FNV-1a 64 位哈希：覆盖全部球的位置/速度/等级/标志以及分数与胜负状态。
+// 浮点按位参与哈希，只在同一构建（同编译器与编译选项）之间可比
+std::uint64_t World::stateHash() const
+{
+    std::uint64_t h = 1469598103934665603ull;
+    auto mix = [&h](const void* data, size_t bytes) {
+        const unsigned char* p = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) {
+            h ^= p[i];
+            h *= 1099511628211ull;
+        }
+    };
+    const size_t n = balls.size();
+    mix(&n, sizeof(n));
+    mix(balls.x.data(), n * sizeof(float));
+    mix(balls.y.data(), n * sizeof(float));
+    mix(balls.vx.data(), n * sizeof(float));
+    mix(balls.vy.data(), n * sizeof(float));
+    mix(balls.level.data(), n);
+    mix(balls.flags.data(), n);
+    mix(&score, sizeof(score));
+    mix(&nextSpawnLevel, sizeof(nextSpawnLevel));
+    unsigned char state = static_cast<unsigned char>((gameOver ? 1 : 0) | (gameWin ? 2 : 0));
+    mix(&state, 1);
+    return h;
+}
+
+void World::reset()
+{
+    balls.clear();
+    score = 0;
+    spawnLocked = false;
+    currentSpawnLevel = 1;
+    gameOver = false;
+    gameWin = false;
+    nextIsland = 0;
+    std::fill(skyline.begin(), skyline.end(), height);
+    std::fill(sleepSkyline.begin(), sleepSkyline.end(), height);
+    stackTop = sleepTop = height;
+    sleepSkylineDirty = false;
+}
+
+// 复制另一个 World 的完整模拟状态（同尺寸、同球数上限时容器容量足够，不触发分配）。
+// 每步的临时缓冲区都在步内重建，不需要复制；线程数与计时开关保持本对象自己的设置
+void World::copyStateFrom(const World& src)
+{
+    if (&src == this) return;
+    width = src.width;
+    height = src.height;
+    substeps = src.substeps;
+    separationPasses = src.separationPasses;
+    mergeCascades = src.mergeCascades;
+    ccdEnabled = src.ccdEnabled;
+    rules = src.rules;
+    kernels = src.kernels;
+    balls = src.balls;
+    sleepEnabled = src.sleepEnabled;
+    nextIsland = src.nextIsland;
+    skyline = src.skyline;
+    sleepSkyline = src.sleepSkyline;
+    sleepSkylineDirty = src.sleepSkylineDirty;
+    sleepTop = src.sleepTop;
+    stackTop = src.stackTop;
+    score = src.score;
+    seed = src.seed;
+    rng = src.rng;
+    stepCount = src.stepCount;
+    spawnLocked = src.spawnLocked;
+    currentSpawnLevel = src.currentSpawnLevel;
+    random23Mode = src.random23Mode;
+    nextSpawnLevel = src.nextSpawnLevel;
+    lifelineY = src.lifelineY;
+    gameOver = src.gameOver;
+    gameWin = src.gameWin;
+    leftMargin = src.leftMargin;
+    rightMargin = src.rightMargin;
+}
+
+bool World::isSupported(size_t idx) const
+{
+    return idx < supported.size() && supported[idx] != 0;
+}
+
+// 用当前网格找出所有满足 near(i, j, 距离平方) 的球对 (a < b)：至少一端醒着（两端都休眠的球对
+// 不会变化，无需扫描）。从 awake 列表出发扫描，按发现顺序写入 out。
+// 有线程池时按 awake 列表分段并行扫描，各段结果按段序拼接，顺序与单线程扫描完全相同。
+template <class Near>
+void World::collectPairs(std::vector<Contact>& out, Near near)
+{
+    auto scan = [&](size_t lo, size_t hi, std::vector<Contact>& dst) {
+        for (size_t k = lo; k < hi; ++k) {
+            const size_t i = static_cast<size_t>(awake[k]);
+            grid.query(balls.x[i], balls.y[i], [&](int jj) {
+                size_t j = static_cast<size_t>(jj);
+                // 两端都醒着的球对只从较小下标一侧记录；醒着-休眠的球对只会从醒着的一侧发现
+                bool sleepingJ = balls.isSleeping(j);
+                if (j == i || (!sleepingJ && j < i)) return;
+                float dx = balls.x[j] - balls.x[i];
+                float dy = balls.y[j] - balls.y[i];
+                if (near(i, j, dx*dx + dy*dy))
+                    dst.push_back({static_cast<int>(std::min(i, j)), static_cast<int>(std::max(i, j))});
+            });
+        }
+    };
+
+    out.clear();
+    const size_t n = awake.size();
+    const size_t PARALLEL_BALLS = 512;
+    if (!pool || n < PARALLEL_BALLS) {
+        scan(0, n, out);
+        return;
+    }
+    const size_t parts = pool->size();
+    pool->parallelFor(parts, 1, 1, [&](size_t lo, size_t hi) {
+        for (size_t t = lo; t < hi; ++t) {
+            pairScratch[t].clear();
+            scan(n * t / parts, n * (t + 1) / parts, pairScratch[t]);
+        }
+    });
+    for (const auto& part : pairScratch)
+        out.insert(out.end(), part.begin(), part.end());
+}
+
+// 醒着且未死亡的球的下标（递增）
+void World::buildAwakeList()
+{
+    awake.clear();
+    for (size_t i = 0; i < balls.size(); ++i)
+        if (!(balls.flags[i] & (BallStore::DEAD | BallStore::SLEEPING)))
+            awake.push_back(static_cast<int>(i));
+}
+
+void World::setSleeping(bool on)
+{
+    sleepEnabled = on;
+    if (on) return;
+    sleepSkylineDirty = true;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        balls.setFlag(i, BallStore::SLEEPING, false);
+        balls.calmTime[i] = 0.f;
+    }
+}
+
+size_t World::getSleepingCount() const
+{
+    size_t count = 0;
+    for (size_t i = 0; i < balls.size(); ++i)
+        if (balls.isSleeping(i)) ++count;
+    return count;
+}
+
+void World::queueWake(int id)
+{
+    if (std::find(pendingWake.begin(), pendingWake.end(), id) == pendingWake.end())
+        pendingWake.push_back(id);
+}
+
+// 唤醒排队中的岛（一次遍历），并刷新 awake 列表
+void World::wakeQueuedIslands()
+{
+    if (pendingWake.empty()) return;
+    for (size_t i = 0; i < balls.size(); ++i) {
+        if (!balls.isSleeping(i)) continue;
+        if (std::find(pendingWake.begin(), pendingWake.end(), balls.island[i]) == pendingWake.end()) continue;
+        balls.setFlag(i, BallStore::SLEEPING, false);
+        balls.calmTime[i] = 0.f;
+        balls.island[i] = -1;
+    }
+    pendingWake.clear();
+    sleepSkylineDirty = true;
+    buildAwakeList();
+}
+
+// 速度超过 WAKE_SPEED 的醒着的球，若与休眠的球接触（距离不超过 rsum + 容差），唤醒对方的岛
+void World::wakeTouchedIslands()
+{
+    if (!sleepEnabled) return;
+    const float EPS = 2.0f;
+    for (int ii : awake) {
+        size_t i = static_cast<size_t>(ii);
+        float v2 = balls.vx[i] * balls.vx[i] + balls.vy[i] * balls.vy[i];
+        if (v2 <= WAKE_SPEED * WAKE_SPEED) continue;
+        grid.query(balls.x[i], balls.y[i], [&](int jj) {
+            size_t j = static_cast<size_t>(jj);
+            if (!balls.isSleeping(j)) return;
+            float dx = balls.x[j] - balls.x[i];
+            float dy = balls.y[j] - balls.y[i];
+            float rsum = balls.radius[i] + balls.radius[j] + EPS;
+            if (dx*dx + dy*dy <= rsum * rsum) queueWake(balls.island[j]);
+        });
+    }
+    wakeQueuedIslands();
+}
+
+int World::findRoot(int k)
+{
+    while (islandParent[k] != k) {
+        islandParent[k] = islandParent[islandParent[k]];
+        k = islandParent[k];
+    }
+    return k;
+}
+
+// 休眠判定（在本步碰撞处理之后、移除死亡球之前调用）：
+// 1. 被推离入睡位置超过 WAKE_DRIFT 的休眠球唤醒所在岛（其下方的球对没有参与求解）；
+// 2. 醒着的球若本子步位移速度低于 SLEEP_SPEED 且被支撑，累计静止时间，否则清零；
+// 3. 以候选球对连通（同一休眠岛的球视为相连）划分岛，岛内醒着的球都静止满 SLEEP_DELAY 时整岛入睡，
+//    并与接触到的休眠岛合并为同一个编号。
+void World::updateSleep(float dt)
+{
+    if (!sleepEnabled || dt <= 0.f) return;
+    const size_t n = balls.size();
+
+    for (const Contact& c : candidates) {
+        const int ends[2] = {c.a, c.b};
+        for (int e : ends) {
+            if (!balls.isSleeping(e)) continue;
+            float dx = balls.x[e] - balls.prevX[e];
+            float dy = balls.y[e] - balls.prevY[e];
+            if (dx*dx + dy*dy > WAKE_DRIFT * WAKE_DRIFT) queueWake(balls.island[e]);
+        }
+    }
+    wakeQueuedIslands();
+
+    bool anyCalm = false;
+    for (int ii : awake) {
+        size_t i = static_cast<size_t>(ii);
+        float dx = balls.x[i] - balls.prevX[i];
+        float dy = balls.y[i] - balls.prevY[i];
+        float limit = SLEEP_SPEED * dt;
+        // 顶部在生命线上方的球不入睡：休眠球因此永远在线下，生命线判定只需看醒着的球
+        bool calm = dx*dx + dy*dy < limit * limit && isSupported(i)
+                    && balls.y[i] - balls.radius[i] > lifelineY;
+        balls.calmTime[i] = calm ? balls.calmTime[i] + dt : 0.f;
+        if (balls.calmTime[i] >= SLEEP_DELAY) anyCalm = true;
+    }
+    if (!anyCalm) return;
+
+    // 并查集：候选球对相连；同一休眠岛的球经该岛第一次出现的球相连
+    islandParent.resize(n);
+    for (size_t i = 0; i < n; ++i) islandParent[i] = static_cast<int>(i);
+    touchedIslands.clear();
+    auto unite = [&](int a, int b) {
+        a = findRoot(a);
+        b = findRoot(b);
+        if (a != b) islandParent[std::max(a, b)] = std::min(a, b);
+    };
+    for (const Contact& c : candidates) {
+        if (balls.isDead(c.a) || balls.isDead(c.b)) continue;
+        unite(c.a, c.b);
+        const int ends[2] = {c.a, c.b};
+        for (int e : ends) {
+            if (!balls.isSleeping(e)) continue;
+            auto it = std::find_if(touchedIslands.begin(), touchedIslands.end(),
+                                   [&](const IslandLink& l) { return l.island == balls.island[e]; });
+            if (it == touchedIslands.end()) touchedIslands.push_back({balls.island[e], e});
+            else unite(it->ball, e);
+        }
+    }
+
+    // 有任何醒着的球尚未静止够久的岛不能入睡
+    islandReady.assign(n, 1);
+    for (int i : awake)
+        if (balls.calmTime[i] < SLEEP_DELAY) islandReady[findRoot(i)] = 0;
+
+    // 入睡：每个就绪的根分配一个新岛编号
+    islandId.assign(n, -1);
+    bool merged = false;
+    for (int i : awake) {
+        int root = findRoot(i);
+        if (!islandReady[root]) continue;
+        if (islandId[root] < 0) islandId[root] = nextIsland++;
+        balls.setFlag(i, BallStore::SLEEPING, true);
+        balls.island[i] = islandId[root];
+        balls.vx[i] = 0.f;
+        balls.vy[i] = 0.f;
+        balls.calmTime[i] = 0.f;
+        // 入睡位置：之后据此判断是否被推动
+        balls.prevX[i] = balls.x[i];
+        balls.prevY[i] = balls.y[i];
+        merged = true;
+    }
+    if (!merged) return;
+    sleepSkylineDirty = true;
+
+    // 与新入睡的球相连的旧休眠岛并入新编号
+    for (IslandLink& l : touchedIslands) {
+        int root = findRoot(l.ball);
+        l.ball = islandReady[root] ? islandId[root] : -1; // 复用为新编号
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (!balls.isSleeping(i)) continue;
+        for (const IslandLink& l : touchedIslands) {
+            if (l.island == balls.island[i] && l.ball >= 0 && l.ball != l.island) {
+                balls.island[i] = l.ball;
+                break;
+            }
+        }
+    }
+}
+
+// 生命线判定（只在非 gameOver 时）：只遍历醒着的球，每步 O(醒着的球数)，不是 O(1)。
+// 休眠的球不移动，不会穿过生命线；顶部在线上方的球又不允许入睡，所以休眠的球不需要累积线上时间。
+// 不能改为只比较堆顶轮廓（stackTop）：轮廓不含下落中的球，而线上计时与"被向上推过"的判定都是逐球的，
+// 改变判定会使已有的记录无法重放。
+void World::checkLifeline(float dt)
+{
+    if (gameOver) return;
+    // 只有当在生命线上停留超过阈值才判定死亡（避免快速连续生成导致的立即死亡）
+    const float ABOVE_THRESHOLD = 1.5f;
+    for (int ii : awake) {
+        size_t b = static_cast<size_t>(ii);
+        float prevTop = balls.prevY[b] - balls.radius[b];
+        float curTop = balls.y[b] - balls.radius[b];
+        // 如果上一帧在生命线下而当前帧在生命线上/线上方 -> 被向上推过，立即判死
+        if (prevTop > lifelineY && curTop <= lifelineY) { gameOver = true; return; }
+
+        // 如果当前在/高于生命线，则开始积累在生命线之上的时间
+        if (curTop <= lifelineY) {
+            balls.timeAboveLine[b] += dt;
+            if (balls.timeAboveLine[b] >= ABOVE_THRESHOLD) { gameOver = true; return; }
+        } else {
+            // 在线下则重置计时
+            balls.timeAboveLine[b] = 0.f;
+        }
+    }
+}
+
+// 把球 i 的上表面并入轮廓：每列取圆在该列水平范围内的最高点，返回球顶 y
+float World::rasterizeTop(std::vector<float>& sky, size_t i) const
+{
+    const float x = balls.x[i];
+    const float y = balls.y[i];
+    const float r = balls.radius[i];
+    const int last = static_cast<int>(sky.size()) - 1;
+    int c0 = std::max(0, static_cast<int>(std::floor((x - r) / SKYLINE_COLUMN)));
+    int c1 = std::min(last, static_cast<int>(std::floor((x + r) / SKYLINE_COLUMN)));
+    for (int c = c0; c <= c1; ++c) {
+        float lo = c * SKYLINE_COLUMN;
+        float hi = lo + SKYLINE_COLUMN;
+        float dx = x < lo ? lo - x : (x > hi ? x - hi : 0.f);
+        if (dx >= r) continue;
+        float top = y - std::sqrt(r * r - dx * dx);
+        if (top < sky[c]) sky[c] = top;
+    }
+    return y - r;
+}
+
+// 顶部轮廓只统计堆上的球（被支撑的球；下落中的球不算）：
+// 休眠球的轮廓只在有球入睡/唤醒时重算，醒着且被支撑的球每子步叠加在其上
+void World::updateSkyline()
+{
+    if (sleepSkylineDirty) {
+        std::fill(sleepSkyline.begin(), sleepSkyline.end(), height);
+        sleepTop = height;
+        for (size_t i = 0; i < balls.size(); ++i) {
+            if (!balls.isSleeping(i) || balls.isDead(i)) continue;
+            sleepTop = std::min(sleepTop, rasterizeTop(sleepSkyline, i));
+        }
+        sleepSkylineDirty = false;
+    }
+    std::copy(sleepSkyline.begin(), sleepSkyline.end(), skyline.begin());
+    stackTop = sleepTop;
+    for (int i : awake) {
+        if (balls.isDead(i) || !isSupported(static_cast<size_t>(i))) continue;
+        stackTop = std::min(stackTop, rasterizeTop(skyline, static_cast<size_t>(i)));
+    }
+}
+
+float World::getColumnTop(float x) const
+{
+    int c = static_cast<int>(std::floor(x / SKYLINE_COLUMN));
+    c = std::max(0, std::min(c, static_cast<int>(skyline.size()) - 1));
+    return skyline[c];
+}
+
+// 由当前网格生成接触表（距离不超过 rsum + EPS 的球对），并建立支撑图：
+// 若 k 与 cur 接触且 k 不高于 cur（pk.y > p.y - 0.5），则 k 支撑 cur。
+// 从接触地面的球出发沿“被支撑”方向一次 BFS 向上传播，得到每个球是否被支撑。
+void World::buildSupportGraph()
+{
+    const float EPS = 2.0f;
+    const size_t n = balls.size();
+
+    collectPairs(contacts, [&](size_t i, size_t j, float d2) {
+        float rsum = balls.radius[i] + balls.radius[j] + EPS;
+        return d2 <= rsum * rsum;
+    });
+
+    // 反向邻接表（CSR）：upStart[k]..upStart[k+1] 为被 k 支撑的球
+    upStart.assign(n + 1, 0);
+    for (const Contact& c : contacts) {
+        float yi = balls.y[c.a];
+        float yj = balls.y[c.b];
+        if (yj > yi - 0.5f) ++upStart[c.b + 1]; // b 支撑 a
+        if (yi > yj - 0.5f) ++upStart[c.a + 1]; // a 支撑 b
+    }
+    for (size_t k = 0; k < n; ++k) upStart[k + 1] += upStart[k];
+    upList.resize(upStart[n]);
+    upFill.assign(upStart.begin(), upStart.end() - 1);
+    for (const Contact& c : contacts) {
+        float yi = balls.y[c.a];
+        float yj = balls.y[c.b];
+        if (yj > yi - 0.5f) upList[upFill[c.b]++] = c.a;
+        if (yi > yj - 0.5f) upList[upFill[c.a]++] = c.b;
+    }
+
+    // 地面接触作为种子，向上传播 grounded 标记
+    supported.assign(n, 0);
+    upFill.clear(); // 复用为 BFS 队列
+    for (size_t k = 0; k < n; ++k) {
+        if (balls.isDead(k)) continue;
+        // 休眠的球只会在被支撑时入睡，同样作为种子
+        if (balls.y[k] + balls.radius[k] >= rules->floorY - EPS || balls.isSleeping(k)) {
+            supported[k] = 1;
+            upFill.push_back(static_cast<int>(k));
+        }
+    }
+    for (size_t head = 0; head < upFill.size(); ++head) {
+        int k = upFill[head];
+        for (int e = upStart[k]; e < upStart[k + 1]; ++e) {
+            int up = upList[e];
+            if (supported[up]) continue;
+            supported[up] = 1;
+            upFill.push_back(up);
+        }
+    }
+}
+
+// 生成分离求解的候选球对（距离小于 rsum + 余量），并做贪心边着色：
+// 每对取两端球都未占用的最小颜色。同色球对不共享球，向量内核可同时处理；
+// 超过 64 色的球对放入最后的溢出批次，按原顺序标量求解。
+void World::buildSolverBatches()
+{
+    const float MARGIN = 4.f; // 本步内推挤可能造成的新接触
+    const size_t n = balls.size();
+
+    collectPairs(candidates, [&](size_t i, size_t j, float d2) {
+        float reach = balls.radius[i] + balls.radius[j] + MARGIN;
+        return d2 < reach * reach;
+    });
+
+    usedColors.assign(n, 0ull);
+    pairColor.resize(candidates.size());
+    batchStart.assign(MAX_SOLVER_COLORS + 2, 0);
+    for (size_t p = 0; p < candidates.size(); ++p) {
+        const Contact& c = candidates[p];
+        unsigned long long used = usedColors[c.a] | usedColors[c.b];
+        int color = MAX_SOLVER_COLORS; // 溢出批次
+        if (~used != 0ull) {
+            color = 0;
+            while (used & (1ull << color)) ++color;
+            usedColors[c.a] |= 1ull << color;
+            usedColors[c.b] |= 1ull << color;
+        }
+        pairColor[p] = static_cast<unsigned char>(color);
+        ++batchStart[color + 1];
+    }
+    for (int c = 0; c <= MAX_SOLVER_COLORS; ++c) batchStart[c + 1] += batchStart[c];
+
+    // 按颜色计数排序（同色内保持发现顺序）
+    solverA.resize(candidates.size());
+    solverB.resize(candidates.size());
+    upFill.assign(batchStart.begin(), batchStart.end() - 1); // 复用为写指针
+    for (size_t p = 0; p < candidates.size(); ++p) {
+        int w = upFill[pairColor[p]]++;
+        solverA[w] = candidates[p].a;
+        solverB[w] = candidates[p].b;
+    }
+}
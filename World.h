@@ -0,0 +1,254 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include "Vec2.h"
+#include "Ball.h"
+#include "Rules.h"
+#include "BallStore.h"
+#include "SpatialGrid.h"
+#include "PhysicsKernels.h"
+#include "ThreadPool.h"
+#include "Profiler.h"
+#include "Rng.h"
+
+// 无窗口的模拟核心：持有全部球的状态、积分、碰撞/合并以及生命线规则。
+// 不依赖 SFML，可在没有显示器的机器上批量运行；Game 只负责输入与渲染。
+// 规则（尺寸、物理常数、等级表）来自构造时给定的 RuleSet，积分内核按该规则集专门实例化；
+// 碰撞、分离与支撑图只读取逐球的半径/质量和运行时的规则集，不随规则集实例化。
+class World {
+public:
+	// 原版规则，可覆盖容器尺寸与球数上限（基准测试与旧的会话记录）
+	explicit World(float width = 480.f, float height = Ball::FLOOR_Y, size_t maxBalls = 200);
+	// 指定规则集（必须是 SBS_RULE_SETS 中的内置规则集），尺寸与球数上限取规则集的值
+	explicit World(const RuleSet& rules);
+	World(const RuleSet& rules, float width, float height, size_t maxBalls);
+
+	// 推进一个固定步：拆成 substeps 个子步，每个子步完整执行积分 -> 碰撞/合并 -> 清理 -> 生命线判定
+	void step(float dt);
+	void setSubsteps(int n) { substeps = n < 1 ? 1 : n; }
+	int getSubsteps() const { return substeps; }
+	// 连锁合并（默认开启）：合成球一出现就与周围同级的球继续合成，整条连锁在同一个子步内完成；
+	// 关闭时合成球要等到下一个子步的接触表里才会再次合并（早期版本的行为，旧记录按此重放）
+	void setMergeCascades(bool on) { mergeCascades = on; }
+	bool isMergeCascadesEnabled() const { return mergeCascades; }
+	// 每个子步的分离求解迭代次数（默认 4）
+	void setSeparationPasses(int n) { separationPasses = n < 1 ? 1 : n; }
+	int getSeparationPasses() const { return separationPasses; }
+	// 连续碰撞检测（默认关闭）：一个子步内位移超过自身半径 CCD_TRAVEL 倍的球沿位移做扫掠圆检测，
+	// 停在与左右墙或其他球的首次接触处并去掉接近方向的速度，因此大步长、少子步时也不会穿过其他球。
+	// 地面由积分内核直接夹紧，不会被穿透
+	void setContinuousCollision(bool on) { ccdEnabled = on; }
+	bool isContinuousCollisionEnabled() const { return ccdEnabled; }
+	static constexpr float CCD_TRAVEL = 0.5f;
+	// 累计做过扫掠的球数，以及其中在子步内被提前截停的次数
+	std::uint64_t getSweptCount() const { return sweptCount; }
+	std::uint64_t getSweepHits() const { return sweepHits; }
+	// 选择积分/分离内核的指令集（默认运行时自动选择最高可用级别）
+	void setSimdLevel(SimdLevel level) { kernels = &PhysicsKernels::get(level, *rules); }
+	SimdLevel getSimdLevel() const { return kernels->level; }
+	// 碰撞阶段使用的线程数（含调用线程，默认 1；0 表示取硬件线程数）。
+	// 球对扫描按球分段、分离求解按颜色批次切分到各线程，结果与单线程逐位一致
+	void setThreads(unsigned n);
+	unsigned getThreads() const { return pool ? pool->size() : 1; }
+	// 在 (x, y) 附近寻找不重叠的位置生成指定等级的球；返回新球的句柄（达到上限时为无效句柄）
+	BallStore::Handle spawnBall(float x, float y, int level);
+	// 使用预选的 nextSpawnLevel 生成球，然后选择新的预览等级（对应一次玩家点击）
+	BallStore::Handle dropNext(float x, float y);
+	// 直接在 (x, y) 放入一个球，不做位置搜索（基准测试/场景搭建用），超过上限时忽略
+	BallStore::Handle addBall(float x, float y, int level, float vx = 0.f, float vy = 0.f);
+	void reset();
+	// 复制 src 的模拟状态（球、分数、随机数、规则状态），用于 AI 推演时廉价地分叉当前局面；
+	// 之后两者独立推进，相同输入下结果与 src 逐位一致。两者应使用同一规则集与球数上限
+	void copyStateFrom(const World& src);
+	// 设定本局随机种子（决定预览等级序列与生成初速度），并按新序列重新选择预览等级；
+	// 同一种子加同样的输入序列可完整复现一局（见 SessionLog）
+	void setSeed(std::uint64_t s);
+	std::uint64_t getSeed() const { return seed; }
+	// 已执行的固定步数（reset 不清零，用作输入事件的时间戳）
+	std::uint64_t getStepCount() const { return stepCount; }
+	// 休眠：静止足够久的连通岛停止积分与球对扫描，被新接触、合并或推动时整岛唤醒（默认开启）
+	void setSleeping(bool on);
+	bool isSleepingEnabled() const { return sleepEnabled; }
+	size_t getSleepingCount() const;
+	// 当前模拟状态的哈希，用于回放校验
+	std::uint64_t stateHash() const;
+
+	// 分阶段耗时（纳秒，累计值），供基准测试拆分每步开销；默认关闭，关闭时不读取时钟
+	struct PhaseTimes {
+		std::uint64_t integrate = 0;  // 积分
+		std::uint64_t support = 0;    // 宽相 + 接触表 + 支撑图
+		std::uint64_t merge = 0;      // 合并判定与生成合成球
+		std::uint64_t separation = 0; // 候选球对着色 + 多遍分离
+		std::uint64_t walls = 0;      // 左右墙约束
+		std::uint64_t other = 0;      // 清理死亡球、稳定判定与生命线
+	};
+	void setPhaseTiming(bool on) { phaseTiming = on; }
+	const PhaseTimes& getPhaseTimes() const { return phaseTimes; }
+	void resetPhaseTimes() { phaseTimes = PhaseTimes(); }
+	// 每步的求解统计（step 开始时清零）：接触对数与合并次数（含连锁）为各子步之和；
+	// 剩余穿透为最后一个子步分离求解之后各候选球对仍然重叠的深度（像素），需要 setOverlapStats 开启，否则为 0
+	struct StepStats {
+		std::uint32_t contacts = 0;
+		std::uint32_t merges = 0;
+		float maxOverlap = 0.f;
+		float sumOverlap = 0.f;
+	};
+	const StepStats& getStepStats() const { return stepStats; }
+	void setOverlapStats(bool on) { overlapStats = on; }
+	bool isOverlapStatsEnabled() const { return overlapStats; }
+	// 挂接剖析器后每个子步的各阶段区间都写入其环形缓冲（同时累加 PhaseTimes）；传 nullptr 取消
+	void setProfiler(Profiler* p) { profiler = p; }
+	Profiler* getProfiler() const { return profiler; }
+
+	const BallStore& getBalls() const { return balls; }
+	// 句柄对应球的当前下标（球已合并或被移除时为 BallStore::NPOS）
+	size_t findBall(BallStore::Handle h) const { return balls.find(h); }
+	int getScore() const { return score; }
+	int getNextSpawnLevel() const { return nextSpawnLevel; }
+	int getMaxLevel() const { return rules->maxLevel; }
+	const RuleSet& getRules() const { return *rules; }
+	bool isGameOver() const { return gameOver; }
+	bool isGameWin() const { return gameWin; }
+	bool isSpawnLocked() const { return spawnLocked; }
+	float getLifelineY() const { return lifelineY; }
+	// 堆顶轮廓（只含被支撑的球，每子步末增量维护，查询 O(1)）：最高球顶的 y（无球时为容器高度），
+	// 及其与生命线的距离（<= 0 表示已经有球顶到达生命线），供 AI 与界面评估危险程度
+	float getStackTop() const { return stackTop; }
+	float getDangerHeight() const { return stackTop - lifelineY; }
+	// 按 SKYLINE_COLUMN 宽的列记录的最高表面 y（空列为容器高度）
+	float getColumnTop(float x) const;
+	const std::vector<float>& getSkyline() const { return skyline; }
+	static constexpr float SKYLINE_COLUMN = 16.f;
+	float getWidth() const { return width; }
+	float getHeight() const { return height; }
+	size_t getMaxBalls() const { return MAX_BALLS; }
+
+private:
+	// 快照直接读写下面的状态字段
+	friend class Snapshot;
+
+	struct Contact { int a; int b; };
+	struct SpawnReq { float x; float y; int level; Vec2 vel; bool merged = false; };
+
+	void substep(float dt);
+	void resolveMerges();
+	void mergeInto(std::vector<SpawnReq>& spawns, float x1, float y1, float x2, float y2, int level);
+	void sweepFastBalls();
+	void sweepBall(int i, float reach);
+	void pickNextSpawnLevel();
+	void reserveScratch();
+	float gridCellSize() const;
+	void buildAwakeList();
+	void wakeTouchedIslands();
+	void queueWake(int island);
+	void wakeQueuedIslands();
+	void updateSleep(float dt);
+	void checkLifeline(float dt);
+	float rasterizeTop(std::vector<float>& sky, size_t i) const;
+	void updateSkyline();
+	int findRoot(int k);
+	void checkCollisions();
+	bool isSupported(size_t idx) const;
+	void buildSupportGraph();
+	void buildSolverBatches();
+	void measureOverlap();
+	template <class Near>
+	void collectPairs(std::vector<Contact>& out, Near near);
+	bool timing() const { return phaseTiming || profiler; }
+	std::uint64_t lap(std::uint64_t& acc, std::uint64_t since, Profiler::Phase phase);
+
+private:
+	const RuleSet* rules;
+	float width;
+	float height;
+	int substeps = 1;
+	int separationPasses = 4;
+	bool phaseTiming = false;
+	PhaseTimes phaseTimes;
+	Profiler* profiler = nullptr;
+	StepStats stepStats;
+	bool overlapStats = false;
+	BallStore balls;
+	// 碰撞宽相网格（每帧重建，缓冲区复用）
+	SpatialGrid grid;
+
+	// 接触表与支撑图（每步在合并前重建一次）
+	// 每球预留的接触/候选球对数：等大圆盘最多 6 个邻居，大小差异与分离余量下也远低于此
+	static constexpr size_t PAIRS_PER_BALL = 16;
+	std::vector<Contact> contacts;
+	std::vector<int> upStart;    // CSR：被球 k 支撑的球为 upList[upStart[k]..upStart[k+1])
+	std::vector<int> upList;
+	std::vector<int> upFill;     // 构建时的写指针，随后复用为 BFS 队列
+	std::vector<char> supported; // 每个球是否被支撑（可经接触链到达地面）
+
+	// 分离求解的候选球对，按贪心边着色排序：同一颜色批次内任意两对不共享球，可整批向量化
+	const PhysicsKernels* kernels;
+	std::unique_ptr<ThreadPool> pool;    // 为空时单线程求解
+	std::vector<std::vector<Contact>> pairScratch; // 并行扫描球对时每段的结果
+	std::vector<Contact> candidates;     // 候选球对（发现顺序）
+	std::vector<int> solverA, solverB;   // 按颜色排序后的球对
+	static constexpr int MAX_SOLVER_COLORS = 64; // 超出的球对进入最后的溢出批次
+	std::vector<int> batchStart;         // 颜色 c 的球对为 solver[batchStart[c]..batchStart[c+1])
+	std::vector<unsigned char> pairColor;
+	std::vector<unsigned long long> usedColors; // 每个球已占用的颜色位
+	std::vector<SpawnReq> spawnRequests;        // 合并产生的新球（本步末尾统一生成，兼作连锁合并的事件队列）
+	bool mergeCascades = true;
+
+	// 连续碰撞
+	bool ccdEnabled = false;
+	std::vector<int> fastBalls;                 // 本子步需要扫掠的球（递增下标）
+	std::uint64_t sweptCount = 0;
+	std::uint64_t sweepHits = 0;
+
+	// 休眠岛
+	static constexpr float SLEEP_SPEED = 5.f;   // 低于该速度（像素/秒）视为静止（堆内求解抖动约 0.5~3）
+	static constexpr float SLEEP_DELAY = 0.5f;  // 静止持续多久（秒）后允许入睡
+	static constexpr float WAKE_SPEED = 30.f;   // 以高于该速度接触休眠球时唤醒其岛
+	static constexpr float WAKE_DRIFT = 1.f;    // 休眠球被推离入睡位置超过该距离（像素）时唤醒
+	struct IslandLink { int island; int ball; };
+	bool sleepEnabled = true;
+	int nextIsland = 0;
+	std::vector<int> awake;                     // 本子步醒着的球（递增下标）
+	std::vector<int> pendingWake;               // 待唤醒的岛编号
+	std::vector<int> islandParent;              // 并查集
+	std::vector<char> islandReady;
+	std::vector<int> islandId;
+	std::vector<IslandLink> touchedIslands;     // 本步接触到的休眠岛及其中一个球
+
+	// 顶部轮廓：休眠球部分缓存到 sleepSkyline，只在休眠集合变化时重算；醒着的球每子步叠加
+	std::vector<float> skyline;
+	std::vector<float> sleepSkyline;
+	bool sleepSkylineDirty = false;
+	float sleepTop = 0.f;
+	float stackTop = 0.f;
+
+	int score = 0;
+	// 本局随机数：预览等级与生成初速度都从这里取，不使用全局 std::rand
+	std::uint64_t seed = 1;
+	Rng rng{1};
+	std::uint64_t stepCount = 0;
+
+	// 游戏限制（默认取规则集的上限，基准测试可放宽）
+	const size_t MAX_BALLS;
+	// 控制生成：当一个或多个球未稳定时禁止产生新的球
+	bool spawnLocked = false;
+
+	// 当前选择生成的等级（1/2/3），3 级需要解锁
+	int currentSpawnLevel = 1;
+	// 现在始终随机生成 1/2/3；第3级受解锁分数限制
+	bool random23Mode = true; // 保留字段以兼容旧逻辑但默认开启（实际我们会随机 1-3）
+
+	// 下一个将要生成的等级（用于 UI 预览）
+	int nextSpawnLevel = 1;
+
+	// 生命线（虚线）Y 坐标（相对于窗口顶部，取自规则集）
+	float lifelineY;
+	bool gameOver = false;
+	bool gameWin = false;
+
+	// 容器边界（留白 margin）
+	float leftMargin = 20.f;
+	float rightMargin = 20.f;
+};
@@ -0,0 +1,209 @@
+// 遥测离线分析：内存映射 bench --telemetry 写出的逐步遥测文件，逐块解码并按段汇总，输出 JSON。
+// 文件整体映射、顺序扫描，解码缓冲逐块复用，内存占用与文件大小无关，可以扫描数 GB 的记录。
+//
+// 编译（不需要 SFML）：
+//   g++ -std=c++17 -O2 -pthread analyze.cpp Telemetry.cpp MappedFile.cpp -o analyze
+// 用法：
+//   ./analyze FILE...
+//   每段（bench 的每个场景）输出：球数、接触数、合并数、分离求解后的剩余穿透（每步最大值的均值与分位数）、
+//   堆顶越过生命线的累计与最长时间、新生成的球数、休眠比例，以及压缩率与扫描吞吐
+#include "Telemetry.h"
+#include "BallStore.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace Telemetry;
+
+// 每步最大剩余穿透的直方图：按量化单位（1/1024 像素）分桶，超出范围的计入最后一个桶
+const size_t OVERLAP_BINS = 8192;
+
+struct RunStats {
+	std::uint32_t run = 0;
+	std::uint64_t firstStep = 0;
+	std::uint64_t lastStep = 0;
+	std::uint64_t steps = 0;
+	std::uint64_t chunks = 0;
+	std::uint64_t gaps = 0;            // 记录中断（写线程落后被丢弃）的步数
+	std::uint64_t rows = 0;
+	std::uint64_t maxBalls = 0;
+	std::uint64_t contacts = 0;
+	std::uint64_t maxContacts = 0;
+	std::uint64_t merges = 0;
+	std::uint64_t maxMerges = 0;
+	std::uint64_t spawned = 0;         // 新出现的球（新句柄）
+	std::uint64_t sleepingRows = 0;
+	std::uint64_t aboveSteps = 0;      // 有球顶越过生命线的步数
+	std::uint64_t aboveStreak = 0;
+	std::uint64_t longestAbove = 0;
+	std::int64_t maxTimeAbove = 0;     // 毫秒
+	std::int64_t sumMaxOverlap = 0;
+	std::int64_t worstOverlap = 0;
+	std::int64_t finalScore = 0;
+	std::int64_t finalFlags = 0;
+	std::uint64_t encodedBytes = 0;
+	std::vector<std::uint64_t> overlapHist = std::vector<std::uint64_t>(OVERLAP_BINS, 0);
+};
+
+// 跨块追踪句柄：某槽位上一次出现时的代数与记录序号，不连续出现的句柄视为新球
+struct HandleTracker {
+	std::vector<std::int64_t> generation;
+	std::vector<std::uint64_t> seen;
+
+	bool isNew(std::int64_t slot, std::int64_t gen, std::uint64_t index)
+	{
+		const size_t s = static_cast<size_t>(slot);
+		if (s >= generation.size()) {
+			generation.resize(s + 1, -1);
+			seen.resize(s + 1, 0);
+		}
+		const bool fresh = generation[s] != gen || seen[s] + 1 != index;
+		generation[s] = gen;
+		seen[s] = index;
+		return fresh;
+	}
+};
+
+double percentile(const std::vector<std::uint64_t>& hist, std::uint64_t total, double q)
+{
+	if (total == 0) return 0.0;
+	const std::uint64_t target = static_cast<std::uint64_t>(q * static_cast<double>(total - 1));
+	std::uint64_t acc = 0;
+	for (size_t b = 0; b < hist.size(); ++b) {
+		acc += hist[b];
+		if (acc > target) return static_cast<double>(b) / OVERLAP_SCALE;
+	}
+	return static_cast<double>(hist.size() - 1) / OVERLAP_SCALE;
+}
+
+void writeRun(std::ostream& out, const RunStats& r, float stepSeconds)
+{
+	const double steps = static_cast<double>(std::max<std::uint64_t>(r.steps, 1));
+	// 原始大小按每个值 4 字节计（未量化、未压缩的列存储）
+	const double raw = 4.0 * (static_cast<double>(r.steps) * FIRST_BALL_COLUMN
+		+ static_cast<double>(r.rows) * (COLUMN_COUNT - FIRST_BALL_COLUMN));
+	out << "    {\"run\": " << r.run << ", \"first_step\": " << r.firstStep << ", \"last_step\": " << r.lastStep
+		<< ", \"steps\": " << r.steps << ", \"chunks\": " << r.chunks << ", \"gap_steps\": " << r.gaps
+		<< ",\n     \"balls_mean\": " << static_cast<double>(r.rows) / steps << ", \"balls_max\": " << r.maxBalls
+		<< ", \"spawned\": " << r.spawned
+		<< ", \"sleeping_fraction\": " << (r.rows ? static_cast<double>(r.sleepingRows) / static_cast<double>(r.rows) : 0.0)
+		<< ",\n     \"contacts_mean\": " << static_cast<double>(r.contacts) / steps << ", \"contacts_max\": " << r.maxContacts
+		<< ", \"merges\": " << r.merges << ", \"merges_max_per_step\": " << r.maxMerges
+		<< ",\n     \"residual_overlap_px\": {\"mean\": " << static_cast<double>(r.sumMaxOverlap) / steps / OVERLAP_SCALE
+		<< ", \"p50\": " << percentile(r.overlapHist, r.steps, 0.50)
+		<< ", \"p99\": " << percentile(r.overlapHist, r.steps, 0.99)
+		<< ", \"max\": " << static_cast<double>(r.worstOverlap) / OVERLAP_SCALE << "}"
+		<< ",\n     \"above_lifeline_seconds\": " << static_cast<double>(r.aboveSteps) * stepSeconds
+		<< ", \"longest_above_seconds\": " << static_cast<double>(r.longestAbove) * stepSeconds
+		<< ", \"max_time_above_seconds\": " << static_cast<double>(r.maxTimeAbove) / 1000.0
+		<< ",\n     \"final_score\": " << r.finalScore << ", \"game_over\": " << ((r.finalFlags & GAME_OVER) ? "true" : "false")
+		<< ", \"game_win\": " << ((r.finalFlags & GAME_WIN) ? "true" : "false")
+		<< ", \"encoded_bytes\": " << r.encodedBytes
+		<< ", \"compression_ratio\": " << (r.encodedBytes ? raw / static_cast<double>(r.encodedBytes) : 0.0) << "}";
+}
+
+int analyze(const std::string& path)
+{
+	TelemetryReader reader;
+	if (!reader.open(path)) {
+		std::cerr << path << ": " << reader.error() << "\n";
+		return 1;
+	}
+	const FileHeader& head = reader.header();
+	const auto t0 = std::chrono::steady_clock::now();
+
+	std::vector<RunStats> runs;
+	HandleTracker handles;
+	std::uint64_t index = 0; // 全文件的记录序号（跨段连续，新段的球一律视为新球）
+	Chunk chunk;
+	while (reader.next(chunk)) {
+		if (runs.empty() || runs.back().run != chunk.run) {
+			runs.emplace_back();
+			runs.back().run = chunk.run;
+			runs.back().firstStep = chunk.firstStep;
+			++index;
+		}
+		RunStats& r = runs.back();
+		++r.chunks;
+		r.encodedBytes += chunk.encodedBytes;
+		std::uint64_t step = chunk.firstStep - 1;
+		size_t row = 0;
+		for (std::uint32_t s = 0; s < chunk.steps; ++s) {
+			step += static_cast<std::uint64_t>(chunk.columns[StepDelta][s]) + 1;
+			// 块内与块间被丢弃的步（块首的步号差总是 0，块间的间隔由块的起始步号得出）
+			const std::uint64_t gap = r.steps > 0 && step > r.lastStep ? step - r.lastStep - 1 : 0;
+			r.gaps += gap;
+			index += gap + 1;
+			++r.steps;
+			r.lastStep = step;
+
+			const std::uint64_t balls = static_cast<std::uint64_t>(chunk.columns[BallCount][s]);
+			const std::uint64_t contacts = static_cast<std::uint64_t>(chunk.columns[Contacts][s]);
+			const std::uint64_t merges = static_cast<std::uint64_t>(chunk.columns[Merges][s]);
+			r.rows += balls;
+			r.maxBalls = std::max(r.maxBalls, balls);
+			r.contacts += contacts;
+			r.maxContacts = std::max(r.maxContacts, contacts);
+			r.merges += merges;
+			r.maxMerges = std::max(r.maxMerges, merges);
+
+			const std::int64_t overlap = std::max<std::int64_t>(0, chunk.columns[MaxOverlap][s]);
+			r.sumMaxOverlap += overlap;
+			r.worstOverlap = std::max(r.worstOverlap, overlap);
+			++r.overlapHist[std::min(static_cast<size_t>(overlap), OVERLAP_BINS - 1)];
+
+			if (chunk.columns[AboveLine][s] > 0) {
+				++r.aboveSteps;
+				r.longestAbove = std::max(r.longestAbove, ++r.aboveStreak);
+			} else {
+				r.aboveStreak = 0;
+			}
+			r.maxTimeAbove = std::max(r.maxTimeAbove, chunk.columns[MaxTimeAbove][s]);
+			r.finalScore = chunk.columns[Score][s];
+			r.finalFlags = chunk.columns[StepFlags][s];
+
+			for (std::uint64_t k = 0; k < balls; ++k, ++row) {
+				if (handles.isNew(chunk.columns[Slot][row], chunk.columns[Generation][row], index)) ++r.spawned;
+				if (chunk.columns[BallFlags][row] & BallStore::SLEEPING) ++r.sleepingRows;
+			}
+		}
+	}
+	if (!reader.error().empty()) {
+		std::cerr << path << ": " << reader.error() << "\n";
+		return 1;
+	}
+	const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+	std::uint64_t rows = 0;
+	for (const RunStats& r : runs) rows += r.rows;
+
+	std::cout << "{\"file\": \"" << path << "\", \"bytes\": " << reader.fileSize() << ", \"rules\": " << head.rules
+		<< ", \"step_seconds\": " << head.stepSeconds << ", \"truncated\": " << (reader.isTruncated() ? "true" : "false")
+		<< ", \"scan_seconds\": " << seconds
+		<< ", \"scan_mb_per_sec\": " << (seconds > 0.0 ? static_cast<double>(reader.fileSize()) / seconds / 1e6 : 0.0)
+		<< ", \"scan_rows_per_sec\": " << (seconds > 0.0 ? static_cast<double>(rows) / seconds : 0.0)
+		<< ",\n  \"runs\": [\n";
+	for (size_t i = 0; i < runs.size(); ++i) {
+		writeRun(std::cout, runs[i], head.stepSeconds);
+		std::cout << (i + 1 < runs.size() ? "," : "") << "\n";
+	}
+	std::cout << "  ]}\n";
+	return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	if (argc < 2) {
+		std::cerr << "usage: analyze FILE...\n";
+		return 2;
+	}
+	int status = 0;
+	for (int i = 1; i < argc; ++i) status |= analyze(argv[i]);
+	return status;
+}
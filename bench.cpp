@@ -0,0 +1,598 @@
+// 无窗口基准测试：在若干可复现的标准场景上运行真实的 World::step（Ball::integrate、碰撞/合并、
+// 分离求解、墙约束、生命线），输出每步平均耗时及各阶段拆分，格式为 JSON / CSV。
+//
+// 编译（不需要 SFML）：
+//   g++ -std=c++17 -O2 -pthread bench.cpp World.cpp Ball.cpp BallStore.cpp SpatialGrid.cpp PhysicsKernels.cpp ThreadPool.cpp SessionLog.cpp AllocCounter.cpp Profiler.cpp Bot.cpp SessionHost.cpp WorkStealingPool.cpp Telemetry.cpp MappedFile.cpp -o bench
+// 用法：
+//   ./bench [--scenario NAME]... [--steps-scale X] [--simd scalar|sse|avx2] [--threads N] [--no-sleep] [--json FILE] [--csv FILE]
+//           [--trace FILE] [--trace-csv FILE] [--step S] [--substeps N] [--passes N] [--ccd]
+//           [--no-cascades] [--telemetry FILE] [--list] [--selftest]
+//   （--trace / --trace-csv 导出计时步内各阶段的区间，分别为 Chrome trace JSON 与 CSV，每个固定步算一帧）
+//   （--step / --substeps / --passes / --ccd 设置固定步长、子步数、分离迭代次数与连续碰撞，
+//     用 bullets 场景的 tunnels 对比大步长下的准确性，用其他场景的 ns_per_step 对比单步开销；
+//     --no-cascades 关闭同一子步内的连锁合并，用 merge_clusters 场景的 settle_steps 对比连锁完成所需的步数）
+//   （--telemetry 把计时步内每步的球状态与求解统计写入遥测文件，每个场景为一段，用 ./analyze 汇总；
+//     记录时同时统计分离求解后的剩余穿透，ns_per_step 会略有增加）
+//   ./bench --replay FILE [--threads N] [--telemetry FILE]
+//           （重放 ./game --record 记录的真实对局并计时、校验结束哈希，可同时写出整局的遥测）
+//   ./bench --sessions 1,4,16,64 [--threads N] [--session-steps S]
+//           （SessionHost 同时运行 N 局随机投放的对局，每个 N 输出一行总步数吞吐与单步耗时分位数）
+#include "World.h"
+#include "PhysicsKernels.h"
+#include "SessionLog.h"
+#include "SessionHost.h"
+#include "AllocCounter.h"
+#include "Profiler.h"
+#include "Telemetry.h"
+#include <algorithm>
+#include <cstdint>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 求解器设置：固定步长、子步数、分离迭代次数、连续碰撞
+struct Solver {
+	float step = 1.f / 60.f;
+	int substeps = 1;
+	int passes = 4;
+	bool ccd = false;
+	bool cascades = true;
+};
+
+// 场景用的确定性随机数（不影响 World 自身的随机数）
+struct Lcg {
+	std::uint32_t state;
+	explicit Lcg(std::uint32_t seed) : state(seed) {}
+	float next(float lo, float hi)
+	{
+		state = state * 1664525u + 1013904223u;
+		return lo + (hi - lo) * static_cast<float>(state >> 8) / 16777216.f;
+	}
+};
+
+const float PILE_SPACING = 2.f * Ball::getRadiusByLevel(3) + 1.f;
+
+// 六角交错堆（奇数行右移半格），等级 1..3 按三着色分配，使六个相邻位置的等级都不同，
+// 因此开局就是接触密集、很少立即合并的堆
+void fillPile(World& w, int count, int rows, std::uint32_t seed)
+{
+	Lcg rng(seed);
+	const int perRow = (count + rows - 1) / rows;
+	const float rowHeight = PILE_SPACING * 0.8660254f; // sqrt(3)/2
+	int placed = 0;
+	for (int r = 0; r < rows && placed < count; ++r) {
+		float y = Ball::FLOOR_Y - PILE_SPACING * 0.5f - r * rowHeight;
+		float shift = (r % 2) ? PILE_SPACING * 0.5f : 0.f;
+		int inRow = (r % 2) ? perRow - 1 : perRow;
+		for (int c = 0; c < inRow && placed < count; ++c, ++placed) {
+			int axial = c - (r - (r & 1)) / 2 - r;
+			int level = 1 + ((axial % 3) + 3) % 3;
+			float x = 20.f + PILE_SPACING * 0.5f + shift + c * PILE_SPACING + rng.next(-0.5f, 0.5f);
+			w.addBall(x, y, level);
+		}
+	}
+}
+
+// 板宽：恰好容纳一行 perRow 个球，两侧各留 20px 边距
+float pileWidth(int count, int rows)
+{
+	const int perRow = (count + rows - 1) / rows;
+	return 40.f + perRow * PILE_SPACING;
+}
+
+// 最高等级的球不再合并：count 个排成 rows 行的六角堆，用来构造球数不变、可完全静止的板面
+const float BIG_SPACING = 2.f * Ball::getRadiusByLevel(10) + 1.f;
+
+void fillMaxLevelRows(World& w, int count, int rows)
+{
+	const int perRow = (count + rows - 1) / rows;
+	int placed = 0;
+	for (int r = 0; r < rows && placed < count; ++r) {
+		float y = Ball::FLOOR_Y - BIG_SPACING * 0.5f - r * BIG_SPACING * 0.8660254f;
+		float shift = (r % 2) ? BIG_SPACING * 0.5f : 0.f;
+		int inRow = (r % 2) ? perRow - 1 : perRow;
+		for (int c = 0; c < inRow && placed < count; ++c, ++placed)
+			w.addBall(20.f + BIG_SPACING * 0.5f + shift + c * BIG_SPACING, y, w.getMaxLevel());
+	}
+}
+
+// 连锁合并柱：自下而上 5,4,3,2,1,1 级紧贴叠放，顶上两个 1 级合并后依次落下触发 2→3→4→5→6
+void buildCascades(World& w, int columns)
+{
+	const float colWidth = 2.f * Ball::getRadiusByLevel(6) + 8.f;
+	for (int c = 0; c < columns; ++c) {
+		float x = 20.f + colWidth * (c + 0.5f);
+		float y = Ball::FLOOR_Y;
+		const int levels[] = {5, 4, 3, 2, 1, 1};
+		for (int level : levels) {
+			float r = Ball::getRadiusByLevel(level);
+			y -= r;
+			w.addBall(x, y, level);
+			y -= r;
+		}
+	}
+}
+
+struct Scenario {
+	std::string name;
+	std::string description;
+	float width;
+	// 球数上限留出余量：合并时死亡的球在本步末尾才移除，上限太紧会让合成球生成失败
+	size_t maxBalls;
+	int warmupSteps;
+	int steps;
+	std::function<void(World&)> setup;
+	// 每个测量步之前调用（不计入耗时），用于模拟持续的投放等输入
+	std::function<void(World&, int)> beforeStep;
+	// 每个测量步之后调用（不计入耗时），返回本步要累加到 checkName 指标上的计数（准确性场景使用）
+	std::string checkName = "";
+	std::function<int(const World&, int)> check = nullptr;
+};
+
+// 穿透测试：板中央地面上一个最高等级的大球，左侧朝其中心偏下以 12000~16000 px/s 水平射出一个 1 级小球，
+// 每 BULLET_STEPS 步重新摆放一次。一步内的位移超过两球半径之和时，离散求解可能让小球越过大球中心、
+// 被分离求解从另一侧推出去；射击结束时小球在大球中心右侧即记为一次穿透
+const int BULLET_STEPS = 60;
+const float BULLET_BOARD = 960.f;
+
+void fireBullet(World& w, int shot)
+{
+	const int top = w.getMaxLevel();
+	const float bigR = Ball::getRadiusByLevel(top);
+	w.addBall(BULLET_BOARD * 0.5f, Ball::FLOOR_Y - bigR, top);
+	// 瞄准大球中心及其下方 30px 以内：偏上的射击会沿球面被弹到高处（甚至越过生命线），测的就不是穿透了
+	const float offset = static_cast<float>((shot * 37) % 31);
+	const float speed = 12000.f + static_cast<float>((shot * 53) % 41) * 100.f;
+	w.addBall(60.f, Ball::FLOOR_Y - bigR + offset, 1, speed, 0.f);
+}
+
+int countTunnels(const World& w, int step)
+{
+	if ((step + 1) % BULLET_STEPS != 0) return 0;
+	const BallStore& b = w.getBalls();
+	float bullet = 0.f, target = BULLET_BOARD;
+	for (size_t i = 0; i < b.size(); ++i) {
+		if (b.level[i] == 1) bullet = b.x[i];
+		else target = b.x[i];
+	}
+	return bullet > target ? 1 : 0;
+}
+
+// 同级团簇：地面上 clusters 个由 7 个 1 级球紧贴组成的六角团（中心一个、周围六个），
+// 合并产生的同级球彼此接触，可以连续合并到 3 级
+const int CLUSTER_STEPS = 120;
+
+float clusterWidth()
+{
+	return 6.f * Ball::getRadiusByLevel(3) + 8.f;
+}
+
+void buildClusters(World& w, int clusters)
+{
+	const float r = Ball::getRadiusByLevel(1);
+	const float d = 2.f * r;
+	for (int c = 0; c < clusters; ++c) {
+		float cx = 20.f + clusterWidth() * (c + 0.5f);
+		float cy = Ball::FLOOR_Y - r - d * 0.8660254f;
+		w.addBall(cx, cy, 1);
+		for (int k = 0; k < 6; ++k) {
+			float a = 1.0471976f * k; // 60°
+			w.addBall(cx + d * std::cos(a), cy + d * std::sin(a), 1);
+		}
+	}
+}
+
+// 还有可以合并的同级接触对的步计 1：累计值即各轮团簇合并完成所需的步数之和
+int countMergeable(const World& w, int)
+{
+	const BallStore& b = w.getBalls();
+	for (size_t i = 0; i < b.size(); ++i) {
+		for (size_t j = i + 1; j < b.size(); ++j) {
+			if (b.level[i] != b.level[j] || b.level[i] >= w.getMaxLevel()) continue;
+			float dx = b.x[i] - b.x[j], dy = b.y[i] - b.y[j];
+			float rsum = b.radius[i] + b.radius[j];
+			if (dx*dx + dy*dy <= rsum * rsum) return 1;
+		}
+	}
+	return 0;
+}
+
+std::vector<Scenario> makeScenarios()
+{
+	std::vector<Scenario> list;
+	list.push_back({"empty_drop", "standard 480px board, one ball dropped every 30 steps into an empty container",
+		480.f, 200, 0, 1800,
+		[](World&) {},
+		[](World& w, int step) {
+			if (step % 30 == 0) w.dropNext(60.f + static_cast<float>((step * 37) % 360), 120.f);
+		}});
+	list.push_back({"stack_200", "200 balls in a settled 8-row hexagonal stack",
+		pileWidth(200, 8), 400, 30, 1200,
+		[](World& w) { fillPile(w, 200, 8, 200u); },
+		nullptr});
+	list.push_back({"settled_200", "201 non-merging max-level balls in two rows, settled for 10 s before measuring",
+		40.f + 101 * BIG_SPACING, 400, 600, 1200,
+		[](World& w) { fillMaxLevelRows(w, 201, 2); },
+		nullptr});
+	list.push_back({"pile_1k", "1000 balls in an 8-row pile on a wide board",
+		pileWidth(1000, 8), 2000, 30, 600,
+		[](World& w) { fillPile(w, 1000, 8, 1000u); },
+		nullptr});
+	list.push_back({"pile_10k", "10000 balls in an 8-row pile on a very wide board",
+		pileWidth(10000, 8), 20000, 30, 120,
+		[](World& w) { fillPile(w, 10000, 8, 10000u); },
+		nullptr});
+	const int cascadeColumns = 64;
+	list.push_back({"merge_cascade", "64 columns of 5-4-3-2-1-1 that merge up to level 6, rebuilt every 150 steps",
+		40.f + cascadeColumns * (2.f * Ball::getRadiusByLevel(6) + 8.f), cascadeColumns * 12, 0, 600,
+		[=](World& w) { buildCascades(w, cascadeColumns); },
+		[=](World& w, int step) {
+			if (step > 0 && step % 150 == 0) { w.reset(); buildCascades(w, cascadeColumns); }
+		}});
+	const int clusters = 32;
+	list.push_back({"merge_clusters", "32 tight hexagonal clusters of seven level-1 balls, rebuilt every 120 steps; counts steps with mergeable contacts",
+		40.f + clusters * clusterWidth(), clusters * 14, 0, 480,
+		[=](World& w) { buildClusters(w, clusters); },
+		[=](World& w, int step) {
+			if (step > 0 && step % CLUSTER_STEPS == 0) { w.reset(); buildClusters(w, clusters); }
+		},
+		"settle_steps", countMergeable});
+	list.push_back({"bullets", "a level-1 ball fired at 12000-16000 px/s into a max-level ball every 60 steps; counts tunnelling",
+		BULLET_BOARD, 16, 0, 1200,
+		[](World& w) { fireBullet(w, 0); },
+		[](World& w, int step) {
+			if (step > 0 && step % BULLET_STEPS == 0) { w.reset(); fireBullet(w, step / BULLET_STEPS); }
+		},
+		"tunnels", countTunnels});
+	return list;
+}
+
+struct Result {
+	std::string name;
+	size_t ballsStart = 0;
+	size_t ballsEnd = 0;
+	int steps = 0;
+	int score = 0;
+	double nsPerStep = 0.0;
+	std::uint64_t allocs = 0; // 测量步内的堆分配次数（仅调试构建统计）
+	size_t sleepingEnd = 0;   // 结束时处于休眠的球数
+	std::string checkName;    // 准确性场景的指标名（tunnels、settle_steps 等）与累计值
+	int checkCount = 0;
+	std::uint64_t swept = 0;  // 连续碰撞扫掠的球次数
+	World::PhaseTimes phases;
+};
+
+std::uint64_t nowNs()
+{
+	return Profiler::now();
+}
+
+Result run(const Scenario& sc, const Solver& solver, SimdLevel simd, unsigned threads, bool sleeping, double stepScale,
+           Profiler* profiler, TelemetryWriter* telemetry)
+{
+	World world(sc.width, Ball::FLOOR_Y, sc.maxBalls);
+	world.setSeed(1);
+	world.setSubsteps(solver.substeps);
+	world.setSeparationPasses(solver.passes);
+	world.setContinuousCollision(solver.ccd);
+	world.setMergeCascades(solver.cascades);
+	world.setSimdLevel(simd);
+	world.setThreads(threads);
+	world.setSleeping(sleeping);
+	sc.setup(world);
+	for (int i = 0; i < sc.warmupSteps; ++i) world.step(solver.step);
+
+	Result r;
+	r.name = sc.name;
+	r.checkName = sc.checkName;
+	r.ballsStart = world.getBalls().size();
+	r.steps = std::max(1, static_cast<int>(sc.steps * stepScale));
+	world.resetPhaseTimes();
+	world.setPhaseTiming(true);
+	world.setProfiler(profiler);
+	world.setOverlapStats(telemetry != nullptr);
+	const std::uint64_t sweptBefore = world.getSweptCount();
+	std::uint64_t total = 0;
+	// 遥测写线程的编码缓冲会增长到峰值容量，它在自己的线程上分配；记录遥测时只统计本线程的分配
+	auto allocCount = [&] { return telemetry ? AllocCounter::threadCount() : AllocCounter::count(); };
+	for (int i = 0; i < r.steps; ++i) {
+		if (sc.beforeStep) sc.beforeStep(world, i);
+		if (profiler) profiler->nextFrame();
+		std::uint64_t a0 = allocCount();
+		std::uint64_t t0 = nowNs();
+		world.step(solver.step);
+		std::uint64_t t1 = nowNs();
+		total += t1 - t0;
+		r.allocs += allocCount() - a0;
+		if (profiler) profiler->record(Profiler::Frame, t0, t1);
+		if (sc.check) r.checkCount += sc.check(world, i);
+		if (telemetry) telemetry->record(world);
+	}
+	r.swept = world.getSweptCount() - sweptBefore;
+	r.ballsEnd = world.getBalls().size();
+	r.sleepingEnd = world.getSleepingCount();
+	r.score = world.getScore();
+	r.nsPerStep = static_cast<double>(total) / r.steps;
+	r.phases = world.getPhaseTimes();
+	return r;
+}
+
+double perStep(std::uint64_t ns, int steps) { return static_cast<double>(ns) / steps; }
+
+void writeJson(std::ostream& out, const std::vector<Result>& results, const Solver& solver, const char* simd, unsigned threads)
+{
+	out << "{\n  \"simd\": \"" << simd << "\",\n  \"threads\": " << threads << ",\n  \"step_seconds\": " << solver.step
+		<< ",\n  \"substeps\": " << solver.substeps << ",\n  \"passes\": " << solver.passes
+		<< ",\n  \"ccd\": " << (solver.ccd ? "true" : "false") << ",\n  \"cascades\": " << (solver.cascades ? "true" : "false")
+		<< ",\n  \"scenarios\": [\n";
+	for (size_t i = 0; i < results.size(); ++i) {
+		const Result& r = results[i];
+		out << "    {\"name\": \"" << r.name << "\", \"balls_start\": " << r.ballsStart
+			<< ", \"balls_end\": " << r.ballsEnd << ", \"sleeping_end\": " << r.sleepingEnd << ", \"steps\": " << r.steps
+			<< ", \"score\": " << r.score << ", \"ns_per_step\": " << r.nsPerStep << ", \"allocs\": " << r.allocs
+			<< ", \"swept\": " << r.swept;
+		if (!r.checkName.empty()) out << ", \"" << r.checkName << "\": " << r.checkCount;
+		out << ", \"phases_ns_per_step\": {"
+			<< "\"integrate\": " << perStep(r.phases.integrate, r.steps)
+			<< ", \"support\": " << perStep(r.phases.support, r.steps)
+			<< ", \"merge\": " << perStep(r.phases.merge, r.steps)
+			<< ", \"separation\": " << perStep(r.phases.separation, r.steps)
+			<< ", \"walls\": " << perStep(r.phases.walls, r.steps)
+			<< ", \"other\": " << perStep(r.phases.other, r.steps) << "}}"
+			<< (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	out << "  ]\n}\n";
+}
+
+void writeCsv(std::ostream& out, const std::vector<Result>& results, const Solver& solver, const char* simd, unsigned threads)
+{
+	out << "scenario,simd,threads,step_seconds,substeps,passes,ccd,cascades,balls_start,balls_end,sleeping_end,steps,score,ns_per_step,allocs,swept,check,check_count,"
+	       "integrate_ns,support_ns,merge_ns,separation_ns,walls_ns,other_ns\n";
+	for (const Result& r : results) {
+		out << r.name << "," << simd << "," << threads << "," << solver.step << "," << solver.substeps << "," << solver.passes
+			<< "," << (solver.ccd ? 1 : 0) << "," << (solver.cascades ? 1 : 0) << "," << r.ballsStart << "," << r.ballsEnd << "," << r.sleepingEnd << "," << r.steps << "," << r.score
+			<< "," << r.nsPerStep << "," << r.allocs << "," << r.swept
+			<< "," << r.checkName << "," << r.checkCount
+			<< "," << perStep(r.phases.integrate, r.steps)
+			<< "," << perStep(r.phases.support, r.steps)
+			<< "," << perStep(r.phases.merge, r.steps)
+			<< "," << perStep(r.phases.separation, r.steps)
+			<< "," << perStep(r.phases.walls, r.steps)
+			<< "," << perStep(r.phases.other, r.steps) << "\n";
+	}
+}
+
+// 多局并发的伸缩性：对每个局数各建一个 SessionHost，运行到全部结束（步数上限或游戏结束）
+int runSessions(const std::vector<size_t>& counts, unsigned threads, std::uint64_t sessionSteps)
+{
+	for (size_t n : counts) {
+		SessionHost::Config cfg;
+		cfg.threads = threads;
+		SessionHost host(cfg);
+		for (size_t i = 0; i < n; ++i)
+			host.addRandom(Rules::CLASSIC, 1000 + i, 30, sessionSteps);
+		host.runToCompletion();
+		SessionHost::Report r = host.report();
+		std::cout << "{\"sessions\": " << r.sessions << ", \"threads\": " << host.getThreads()
+			<< ", \"steps\": " << r.steps << ", \"rounds\": " << r.rounds << ", \"seconds\": " << r.seconds
+			<< ", \"steps_per_sec\": " << r.stepsPerSecond << ", \"p50_step_ns\": " << r.p50Ns
+			<< ", \"p99_step_ns\": " << r.p99Ns << ", \"max_step_ns\": " << r.maxNs
+			<< ", \"steals\": " << r.steals << "}" << std::endl;
+	}
+	return 0;
+}
+
+// 与 SessionLog::replay 相同的逐步重放，每步之后写入遥测
+SessionLog::ReplayResult replayWithTelemetry(const SessionLog& log, unsigned threads, TelemetryWriter& telemetry, const std::string& path)
+{
+	SessionLog::ReplayResult result;
+	std::unique_ptr<World> created = log.createWorld(threads);
+	if (!created) {
+		result.message = "unknown rule set";
+		return result;
+	}
+	World& world = *created;
+	if (!telemetry.open(path, world.getRules(), log.getStepSeconds(), world.getMaxBalls())) {
+		result.message = "cannot write " + path;
+		return result;
+	}
+	world.setOverlapStats(true);
+
+	const std::uint64_t t0 = nowNs();
+	size_t next = 0;
+	for (std::uint64_t step = 0; step < log.getFinalStep(); ++step) {
+		if (!log.applyEvents(world, step, next, result.message)) {
+			result.steps = step;
+			result.hash = world.stateHash();
+			return result;
+		}
+		world.step(log.getStepSeconds());
+		telemetry.record(world);
+	}
+	result.seconds = static_cast<double>(nowNs() - t0) * 1e-9;
+	result.steps = log.getFinalStep();
+	result.hash = world.stateHash();
+	result.ok = log.checkEnd(world, next, result.message);
+	return result;
+}
+
+// 关闭遥测文件并报告写出的步数与大小
+bool finishTelemetry(TelemetryWriter& telemetry, const std::string& path)
+{
+	telemetry.close();
+	std::cerr << "telemetry: " << telemetry.getRecordedSteps() << " steps, " << telemetry.getWrittenChunks() << " chunks, "
+		<< telemetry.getWrittenBytes() << " bytes, " << telemetry.getDroppedSteps() << " dropped steps -> " << path << "\n";
+	if (telemetry.hasWriteError()) std::cerr << "cannot write " << path << "\n";
+	return !telemetry.hasWriteError();
+}
+
+int usage()
+{
+	std::cerr << "usage: bench [--scenario NAME]... [--steps-scale X] [--simd scalar|sse|avx2] [--threads N] [--no-sleep]\n"
+	             "             [--json FILE] [--csv FILE] [--trace FILE] [--trace-csv FILE]\n"
+	             "             [--step S] [--substeps N] [--passes N] [--ccd] [--no-cascades] [--telemetry FILE] [--list] [--selftest]\n"
+	             "       bench --replay FILE [--threads N] [--telemetry FILE]\n"
+	             "       bench --sessions N[,N...] [--threads N] [--session-steps S]\n";
+	return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+	std::vector<Scenario> scenarios = makeScenarios();
+	std::vector<std::string> selected;
+	SimdLevel simd = PhysicsKernels::detect();
+	unsigned threads = 1;
+	bool sleeping = true;
+	double stepScale = 1.0;
+	Solver solver;
+	std::string jsonPath, csvPath, replayPath, tracePath, traceCsvPath, telemetryPath;
+	std::vector<size_t> sessionCounts;
+	std::uint64_t sessionSteps = 3600;
+
+	for (int i = 1; i < argc; ++i) {
+		std::string arg = argv[i];
+		auto value = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : nullptr; };
+		if (arg == "--scenario") {
+			const char* v = value(); if (!v) return usage();
+			selected.push_back(v);
+		} else if (arg == "--steps-scale") {
+			const char* v = value(); if (!v) return usage();
+			stepScale = std::atof(v);
+		} else if (arg == "--simd") {
+			const char* v = value(); if (!v) return usage();
+			if (std::strcmp(v, "scalar") == 0) simd = SimdLevel::Scalar;
+			else if (std::strcmp(v, "sse") == 0) simd = SimdLevel::SSE;
+			else if (std::strcmp(v, "avx2") == 0) simd = SimdLevel::AVX2;
+			else return usage();
+		} else if (arg == "--threads") {
+			const char* v = value(); if (!v) return usage();
+			threads = static_cast<unsigned>(std::atoi(v));
+		} else if (arg == "--json") {
+			const char* v = value(); if (!v) return usage();
+			jsonPath = v;
+		} else if (arg == "--csv") {
+			const char* v = value(); if (!v) return usage();
+			csvPath = v;
+		} else if (arg == "--trace") {
+			const char* v = value(); if (!v) return usage();
+			tracePath = v;
+		} else if (arg == "--trace-csv") {
+			const char* v = value(); if (!v) return usage();
+			traceCsvPath = v;
+		} else if (arg == "--telemetry") {
+			const char* v = value(); if (!v) return usage();
+			telemetryPath = v;
+		} else if (arg == "--step") {
+			const char* v = value(); if (!v) return usage();
+			solver.step = static_cast<float>(std::atof(v));
+			if (!(solver.step > 0.f)) return usage();
+		} else if (arg == "--substeps") {
+			const char* v = value(); if (!v) return usage();
+			solver.substeps = std::max(1, std::atoi(v));
+		} else if (arg == "--passes") {
+			const char* v = value(); if (!v) return usage();
+			solver.passes = std::max(1, std::atoi(v));
+		} else if (arg == "--ccd") {
+			solver.ccd = true;
+		} else if (arg == "--no-cascades") {
+			solver.cascades = false;
+		} else if (arg == "--no-sleep") {
+			sleeping = false;
+		} else if (arg == "--replay") {
+			const char* v = value(); if (!v) return usage();
+			replayPath = v;
+		} else if (arg == "--sessions") {
+			const char* v = value(); if (!v) return usage();
+			for (const char* p = v; *p; ) {
+				char* end = nullptr;
+				unsigned long n = std::strtoul(p, &end, 10);
+				if (end == p || n == 0) return usage();
+				sessionCounts.push_back(n);
+				p = (*end == ',') ? end + 1 : end;
+			}
+		} else if (arg == "--session-steps") {
+			const char* v = value(); if (!v) return usage();
+			sessionSteps = std::strtoull(v, nullptr, 10);
+		} else if (arg == "--list") {
+			for (const auto& sc : scenarios) std::cout << sc.name << "\t" << sc.description << "\n";
+			return 0;
+		} else if (arg == "--selftest") {
+			return PhysicsKernels::selfTest(std::cout) ? 0 : 1;
+		} else {
+			return usage();
+		}
+	}
+
+	if (!replayPath.empty()) {
+		SessionLog log;
+		if (!log.load(replayPath)) {
+			std::cerr << "cannot read session log " << replayPath << "\n";
+			return 2;
+		}
+		TelemetryWriter::Config cfg;
+		cfg.dropWhenBehind = false;
+		TelemetryWriter telemetry(cfg);
+		SessionLog::ReplayResult r = telemetryPath.empty() ? log.replay(threads)
+			: replayWithTelemetry(log, threads, telemetry, telemetryPath);
+		if (telemetry.isOpen() && !finishTelemetry(telemetry, telemetryPath)) r.ok = false;
+		std::cout << "{\"replay\": \"" << replayPath << "\", \"events\": " << log.getEvents().size()
+			<< ", \"steps\": " << r.steps << ", \"ns_per_step\": " << (r.steps ? r.seconds * 1e9 / r.steps : 0.0)
+			<< ", \"ok\": " << (r.ok ? "true" : "false") << "}\n";
+		if (!r.ok) std::cerr << r.message << "\n";
+		return r.ok ? 0 : 1;
+	}
+
+	if (!sessionCounts.empty()) return runSessions(sessionCounts, threads, sessionSteps);
+
+	const char* simdName = PhysicsKernels::get(simd).name;
+	// 导出区间时用足够大的环形缓冲容纳全部场景（约 1M 个事件，超出时只保留最新的）
+	std::unique_ptr<Profiler> profiler;
+	if (!tracePath.empty() || !traceCsvPath.empty()) profiler.reset(new Profiler(1 << 20));
+	auto isSelected = [&](const Scenario& sc) {
+		return selected.empty() || std::find(selected.begin(), selected.end(), sc.name) != selected.end();
+	};
+	// 遥测：每个场景记为一段，块缓冲按选中场景中最大的球数上限预留
+	std::unique_ptr<TelemetryWriter> telemetry;
+	if (!telemetryPath.empty()) {
+		size_t maxBalls = 1;
+		for (const auto& sc : scenarios)
+			if (isSelected(sc)) maxBalls = std::max(maxBalls, sc.maxBalls);
+		// 记录在计时区间之外，写线程落后时在块边界等待而不是丢步，不影响 ns_per_step
+		TelemetryWriter::Config cfg;
+		cfg.dropWhenBehind = false;
+		telemetry.reset(new TelemetryWriter(cfg));
+		if (!telemetry->open(telemetryPath, Rules::CLASSIC, solver.step, maxBalls)) {
+			std::cerr << "cannot write " << telemetryPath << "\n";
+			return 2;
+		}
+	}
+	std::vector<Result> results;
+	for (const auto& sc : scenarios) {
+		if (!isSelected(sc)) continue;
+		std::cerr << "running " << sc.name << " ..." << std::endl;
+		results.push_back(run(sc, solver, simd, threads, sleeping, stepScale, profiler.get(), telemetry.get()));
+		if (telemetry) telemetry->nextRun();
+	}
+	if (telemetry && !finishTelemetry(*telemetry, telemetryPath)) return 1;
+	if (results.empty()) {
+		std::cerr << "no matching scenario (see --list)\n";
+		return 2;
+	}
+
+	if (!jsonPath.empty()) { std::ofstream f(jsonPath); writeJson(f, results, solver, simdName, threads); }
+	if (!csvPath.empty()) { std::ofstream f(csvPath); writeCsv(f, results, solver, simdName, threads); }
+	if (jsonPath.empty() && csvPath.empty()) writeJson(std::cout, results, solver, simdName, threads);
+	if (!tracePath.empty() && !profiler->writeChromeTrace(tracePath)) std::cerr << "cannot write " << tracePath << "\n";
+	if (!traceCsvPath.empty() && !profiler->writeCsv(traceCsvPath)) std::cerr << "cannot write " << traceCsvPath << "\n";
+	return 0;
+}
@@ -1,3 +1,213 @@
 #include "Game.h"
+#include "Bot.h"
+#include "PhysicsKernels.h"
+#include "SessionLog.h"
+#include "SessionHost.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
 
-int main() { Game game; game.run(); return 0; }
\ No newline at end of file
+// 无窗口重放一局记录，校验结束状态哈希
+static int replaySession(const char* path)
+{
+    SessionLog log;
+    if (!log.load(path)) {
+        std::cerr << "cannot read session log " << path << std::endl;
+        return 2;
+    }
+    SessionLog::ReplayResult r = log.replay();
+    std::cout << path << ": " << log.getEvents().size() << " events, " << r.steps << " steps in "
+              << r.seconds << " s -> " << (r.ok ? "OK" : r.message) << std::endl;
+    return r.ok ? 0 : 1;
+}
+
+// 无窗口的 AI 对局：每次投放前由 Bot 推演选择位置，投放后推进与推演相同的步数。
+// 输出每局结果与推演吞吐（每秒推演局数 / 模拟步数）；recordPath 非空时把全部对局记录为一个会话
+static int runBot(const RuleSet& rules, std::uint64_t seed, const Bot::Config& cfg, int games, int maxDrops,
+                  const std::string& recordPath)
+{
+    World world(rules);
+    world.setSeed(seed);
+    Bot bot(cfg);
+    SessionLog log;
+    log.begin(world, Bot::STEP);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int g = 0; g < games; ++g) {
+        if (g > 0) {
+            log.recordReset(world);
+            world.reset();
+        }
+        int drops = 0;
+        while (drops < maxDrops && !world.isGameOver() && !world.isGameWin()) {
+            float x = bot.chooseDrop(world);
+            log.recordDrop(world, x, Bot::DROP_Y);
+            world.dropNext(x, Bot::DROP_Y);
+            ++drops;
+            for (int s = 0; s < cfg.settleSteps && !world.isGameOver(); ++s)
+                world.step(Bot::STEP);
+        }
+        std::cout << "game " << g + 1 << ": score " << world.getScore() << ", drops " << drops
+                  << ", balls " << world.getBalls().size()
+                  << (world.isGameWin() ? ", win" : world.isGameOver() ? ", game over" : ", drop limit") << std::endl;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    const Bot::Stats& st = bot.getStats();
+    std::cout << "bot: " << bot.getThreads() << " threads, " << st.decisions << " decisions, "
+              << st.rollouts << " rollouts, " << st.steps << " simulated steps in " << seconds << " s ("
+              << (st.seconds > 0.0 ? st.rollouts / st.seconds : 0.0) << " rollouts/s, "
+              << (st.seconds > 0.0 ? st.steps / st.seconds : 0.0) << " steps/s)" << std::endl;
+
+    if (!recordPath.empty()) {
+        log.finish(world);
+        if (!log.save(recordPath)) {
+            std::cerr << "failed to write session log " << recordPath << std::endl;
+            return 1;
+        }
+        std::cout << "session recorded to " << recordPath << " (seed " << seed << ")" << std::endl;
+    }
+    return 0;
+}
+
+static void printHostReport(const SessionHost& host)
+{
+    SessionHost::Report r = host.report();
+    std::cout << "host: " << r.sessions << " sessions on " << host.getThreads() << " threads, " << r.steps
+              << " steps in " << r.seconds << " s (" << r.stepsPerSecond << " steps/s), step p50 "
+              << r.p50Ns / 1000.0 << " us, p99 " << r.p99Ns / 1000.0 << " us, max " << r.maxNs / 1000.0
+              << " us, " << r.steals << " steals" << std::endl;
+}
+
+// 服务器端校验：所有记录作为独立对局在同一个 SessionHost 上并发重放，逐个报告是否与记录一致
+static int validateSessions(const std::vector<std::string>& paths, unsigned threads)
+{
+    SessionHost::Config cfg;
+    cfg.threads = threads;
+    cfg.stepsPerRound = 60;
+    SessionHost host(cfg);
+    std::vector<SessionLog> logs(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        if (!logs[i].load(paths[i])) {
+            std::cerr << "cannot read session log " << paths[i] << std::endl;
+            return 2;
+        }
+        host.addReplay(logs[i]);
+    }
+    host.runToCompletion();
+    int failed = 0;
+    for (size_t i = 0; i < paths.size(); ++i) {
+        const SessionHost::Session& s = host.get(i);
+        std::cout << paths[i] << ": score " << s.world->getScore() << ", " << s.steps << " steps -> "
+                  << (s.ok ? "OK" : s.message) << std::endl;
+        if (!s.ok) ++failed;
+    }
+    printHostReport(host);
+    return failed ? 1 : 0;
+}
+
+// 锦标赛：games 个 Bot 对局（种子 seed, seed + 1, ...）同时运行，按得分排名
+static int runTournament(const RuleSet& rules, std::uint64_t seed, const Bot::Config& cfg, int games, int maxDrops)
+{
+    SessionHost::Config hostCfg;
+    hostCfg.threads = cfg.threads;
+    hostCfg.stepsPerRound = cfg.settleSteps;
+    SessionHost host(hostCfg);
+    const std::uint64_t maxSteps = static_cast<std::uint64_t>(maxDrops) * static_cast<std::uint64_t>(cfg.settleSteps);
+    for (int g = 0; g < games; ++g)
+        host.addBot(rules, seed + static_cast<std::uint64_t>(g), cfg, maxSteps);
+    host.runToCompletion();
+
+    std::vector<size_t> rank(host.size());
+    for (size_t i = 0; i < rank.size(); ++i) rank[i] = i;
+    std::stable_sort(rank.begin(), rank.end(), [&](size_t a, size_t b) {
+        return host.get(a).world->getScore() > host.get(b).world->getScore();
+    });
+    for (size_t k = 0; k < rank.size(); ++k) {
+        const World& w = *host.get(rank[k]).world;
+        std::cout << "#" << k + 1 << " seed " << seed + rank[k] << ": score " << w.getScore() << ", balls "
+                  << w.getBalls().size() << (w.isGameWin() ? ", win" : w.isGameOver() ? ", game over" : ", drop limit")
+                  << std::endl;
+    }
+    printHostReport(host);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    // 默认每局使用不同的种子；--seed 指定种子以复现
+    std::uint64_t seed = (static_cast<std::uint64_t>(std::random_device{}()) << 32)
+        ^ static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::string recordPath;
+    bool startupReport = false;
+    bool botMode = false;
+    Bot::Config botConfig;
+    int botGames = 1;
+    int botMaxDrops = 1000;
+    const RuleSet* rules = &Rules::CLASSIC;
+    int tournamentGames = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        // --selftest：校验向量化物理内核与标量实现一致（无需窗口）
+        if (std::strcmp(argv[i], "--selftest") == 0)
+            return PhysicsKernels::selfTest(std::cout) ? 0 : 1;
+        // --replay FILE：无窗口以最高速度重放记录并校验（无需窗口）
+        if (std::strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+            return replaySession(argv[i + 1]);
+        // --validate FILE...：在多局主机上并发重放多份记录并逐个校验（放在最后，之后的参数都视为文件）
+        if (std::strcmp(argv[i], "--validate") == 0)
+            return validateSessions(std::vector<std::string>(argv + i + 1, argv + argc), botConfig.threads);
+        if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+            recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+            seed = std::strtoull(argv[++i], nullptr, 10);
+        // --rules NAME：选择内置规则集（classic / wide / deep）
+        else if (std::strcmp(argv[i], "--rules") == 0 && i + 1 < argc) {
+            rules = Rules::findByName(argv[++i]);
+            if (!rules) {
+                std::cerr << "unknown rule set " << argv[i] << "; available:";
+                for (const RuleSet* r : Rules::ALL) std::cerr << " " << r->name;
+                std::cerr << std::endl;
+                return 2;
+            }
+        }
+        // --startup-time：资源加载完成后输出冷/热启动耗时并退出
+        else if (std::strcmp(argv[i], "--startup-time") == 0)
+            startupReport = true;
+        // --bot：无窗口由蒙特卡洛 AI 自动对局，可配合以下参数
+        else if (std::strcmp(argv[i], "--bot") == 0)
+            botMode = true;
+        // --tournament N：N 局 Bot 对局在多局主机上同时运行并排名（共用 --bot 的参数）
+        else if (std::strcmp(argv[i], "--tournament") == 0 && i + 1 < argc)
+            tournamentGames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--games") == 0 && i + 1 < argc)
+            botGames = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--max-drops") == 0 && i + 1 < argc)
+            botMaxDrops = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            botConfig.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (std::strcmp(argv[i], "--candidates") == 0 && i + 1 < argc)
+            botConfig.candidates = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--rollouts") == 0 && i + 1 < argc)
+            botConfig.rollouts = std::atoi(argv[++i]);
+    }
+
+    if (tournamentGames > 0) {
+        botConfig.seed = seed;
+        return runTournament(*rules, seed, botConfig, tournamentGames, botMaxDrops);
+    }
+    if (botMode) {
+        botConfig.seed = seed;
+        return runBot(*rules, seed, botConfig, botGames, botMaxDrops, recordPath);
+    }
+
+    Game game(*rules, seed, recordPath);
+    game.setStartupReport(startupReport);
+    game.run();
+    return 0;
+}